@@ -0,0 +1,1471 @@
+/**
+ *  @brief		Benchmark suite for the packet path of the device stack
+ *  @file		feldbus_bench.cpp
+ *  @ingroup	feldbus-slave-sim
+ *
+ * Feeds complete request frames through the interrupt interface
+ * (turag_feldbus_device_byte_received(), turag_feldbus_device_receive_timeout_occured()),
+ * turag_feldbus_do_processing() and the transmit interrupts and measures the time
+ * spent in each stage. The hardware interface is provided by the host simulation
+ * without an open transport, so the benchmark itself acts as interrupt controller.
+ *
+ * Each benchmark produces one line of JSON on stdout:
+ * - ns_per_packet: time of all stages for one request/response cycle
+ * - rx_isr_ns_per_byte: time spent in turag_feldbus_device_byte_received() per request byte
+ * - timeout_isr_ns: time spent in turag_feldbus_device_receive_timeout_occured()
+ *   (turag_feldbus_device_block_received() with TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER)
+ * - processing_ns: time spent in turag_feldbus_do_processing()
+ * - tx_isr_ns_per_byte: time spent in the transmit interrupts per response byte
+ *   (turag_feldbus_device_block_transmitted() with TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER)
+ * - response_bytes_per_s: response bytes the device stack could generate per second
+ * - bus_ns: time request and response need on the bus with the given baud rate
+ *
+ * The first line describes the configuration. All times include the overhead
+ * of reading the clock (clock_overhead_ns) once per stage.
+ *
+ * Build (from the repository root):
+ *
+ *     gcc -O2 -c -Ibench -Isrc src/feldbus/device/feldbus_aseb.c src/feldbus/device/feldbus_stellantriebe.c src/feldbus/util/crc_checksum.c src/feldbus/util/murmurhash3.c
+ *     g++ -std=gnu++20 -O2 -Ibench -Isrc bench/feldbus_bench.cpp src/feldbus/device/feldbus_base.cpp src/feldbus/device/feldbus_coroutine.cpp src/feldbus/sim/feldbus_sim.cpp *.o -pthread -o feldbus_bench
+ *
+ * The debug log is disabled like in a release build of a device. Add
+ * -DTURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED=1 to both commands for base.read_log.
+ *
+ * With --stress the benchmarks are skipped. Instead the host simulation runs the
+ * interrupts on its own thread and a second thread calls turag_feldbus_do_processing()
+ * in a loop, while requests are sent over the simulated bus for the given
+ * number of seconds. The result is printed as one line of JSON and the exit code is 1
+ * if a request was not answered correctly or the device lost a package.
+ *
+ * Usage: feldbus_bench [--iterations N] [--baudrate B] [--filter SUBSTRING] [--stress SECONDS]
+ */
+
+#include <feldbus/device/feldbus_base.h>
+#include <feldbus/device/feldbus_aseb.h>
+#include <feldbus/device/feldbus_coroutine.h>
+#include <feldbus/device/feldbus_stellantriebe.h>
+#include <feldbus/protocol/flexible_io_protocol.h>
+#include <feldbus/protocol/simple_io_protocol.h>
+#include <feldbus/sim/feldbus_sim.h>
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <unistd.h>
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// with 2-byte addresses both bytes need to be checked by the device
+constexpr FeldbusAddress_t device_address = TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH == 2 ? 0x0311 : 0x11;
+// address of another device on the bus
+constexpr FeldbusAddress_t foreign_address = device_address + 1;
+constexpr uint32_t device_uuid = 0xC0FFEE42;
+
+enum class Protocol {
+	base,
+	stellantriebe,
+	aseb,
+	deferred,
+	coroutine
+};
+
+struct Benchmark {
+	const char* name;
+	Protocol protocol;
+	bool broadcast;
+	std::vector<uint8_t> payload;
+	// requests sent once before measuring
+	std::vector<std::vector<uint8_t>> setup;
+	// the request is addressed to another device and must not be answered
+	bool foreign = false;
+	// called after each request, stands in for the rest of the main loop
+	void (*idle)() = nullptr;
+	// checks the behaviour once before measuring, returns false on failure
+	bool (*check)(const std::vector<uint8_t>& frame, void (*idle)()) = nullptr;
+	// cleans up after measuring, so the next benchmark starts from a known state
+	bool (*finish)(const std::vector<uint8_t>& frame, void (*idle)()) = nullptr;
+};
+
+struct Timing {
+	uint64_t rx_isr_ns = 0;
+	uint64_t timeout_isr_ns = 0;
+	uint64_t processing_ns = 0;
+	uint64_t tx_isr_ns = 0;
+	uint64_t response_bytes = 0;
+};
+
+
+/*
+ * static storage
+ */
+uint8_t storage[4096];
+// number of writes to the storage, the persistent address must not wear it out
+unsigned storage_writes = 0;
+// largest block that fits into a write request
+constexpr uint16_t storage_transfer_size = TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - 8;
+
+/*
+ * Stellantriebe device
+ */
+int32_t st_position = 123456;
+int16_t st_velocity = -321;
+uint8_t st_mode = 2;
+float st_gain = 1.5f;
+int32_t st_values[16];
+
+feldbus_stellantriebe_command_t st_command_set[] = {
+	{ &st_position, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_AND_WRITE_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 0.001f },
+	{ &st_velocity, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_AND_WRITE_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_SHORT, 0.01f },
+	{ &st_mode, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_AND_WRITE_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_CHAR, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_FACTOR_CONTROL_VALUE },
+	{ &st_gain, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_AND_WRITE_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_FLOAT, 1.0f },
+	{ &st_values[0], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+	{ &st_values[1], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+	{ &st_values[2], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+	{ &st_values[3], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+	{ &st_values[4], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+	{ &st_values[5], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+	{ &st_values[6], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+	{ &st_values[7], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+	{ &st_values[8], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+	{ &st_values[9], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+	{ &st_values[10], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+	{ &st_values[11], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+	{ &st_values[12], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+	{ &st_values[13], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+	{ &st_values[14], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+	{ &st_values[15], TURAG_FELDBUS_STELLANTRIEBE_COMMAND_ACCESS_READ_ONLY_ACCESS, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_LENGTH_LONG, 1.0f },
+};
+
+const char* st_command_names[] = {
+	"position", "velocity", "mode", "gain",
+	"value 0", "value 1", "value 2", "value 3",
+	"value 4", "value 5", "value 6", "value 7",
+	"value 8", "value 9", "value 10", "value 11",
+	"value 12", "value 13", "value 14",
+	// longer than a package, so it is truncated unless it is read in segments
+	"value 15, which is described by a text that does not fit into one package of the benchmark device, "
+	"not even with the larger buffers that are used to compare configurations",
+};
+// key of the command whose name does not fit into a package
+constexpr uint8_t st_long_name_key = sizeof(st_command_names) / sizeof(st_command_names[0]);
+
+/*
+ * ASEB device
+ */
+feldbus_aseb_digital_io_t aseb_digital_inputs[16] = {
+	{1, "in 0"}, {0, "in 1"}, {1, "in 2"}, {0, "in 3"},
+	{1, "in 4"}, {0, "in 5"}, {1, "in 6"}, {0, "in 7"},
+	{1, "in 8"}, {0, "in 9"}, {1, "in 10"}, {0, "in 11"},
+	{1, "in 12"}, {0, "in 13"}, {1, "in 14"}, {0, "in 15"},
+};
+feldbus_aseb_digital_io_t aseb_digital_outputs[8] = {
+	{0, "out 0"}, {0, "out 1"}, {0, "out 2"}, {0, "out 3"},
+	{0, "out 4"}, {0, "out 5"}, {0, "out 6"}, {0, "out 7"},
+};
+feldbus_aseb_analog_t aseb_analog_inputs[8] = {
+	{0.1f, 100, "analog 0"}, {0.1f, 200, "analog 1"}, {0.1f, 300, "analog 2"}, {0.1f, 400, "analog 3"},
+	{0.1f, 500, "analog 4"}, {0.1f, 600, "analog 5"}, {0.1f, 700, "analog 6"}, {0.1f, 800, "analog 7"},
+};
+feldbus_aseb_pwm_t aseb_pwm_outputs[2] = {
+	{20000, 1000, 0, 0, 0, "pwm 0"},
+	{20000, 1000, 0, 0, 0, "pwm 1"},
+};
+
+/*
+ * devices with deferred answers
+ */
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE > 0
+// idle calls until a deferred answer is complete
+constexpr unsigned deferred_idle_steps = 2;
+// requests that reached the packet processor or the coroutine handler
+unsigned deferred_calls = 0;
+
+uint8_t* deferred_buffer;
+uint8_t deferred_value;
+unsigned deferred_countdown;
+
+// answers {x} with {x, ~x} once deferred_idle() was called deferred_idle_steps times
+FeldbusSize_t deferred_process_package(const uint8_t* message, FeldbusSize_t, uint8_t*) {
+	++deferred_calls;
+	uint8_t* buffer = turag_feldbus_device_defer_answer();
+	if (buffer) {
+		deferred_buffer = buffer;
+		deferred_value = message[0];
+		deferred_countdown = deferred_idle_steps;
+	}
+	return TURAG_FELDBUS_DEFERRED_ANSWER;
+}
+
+// the task that completes the deferred answer
+void deferred_idle() {
+	if (deferred_buffer && --deferred_countdown == 0) {
+		deferred_buffer[0] = deferred_value;
+		deferred_buffer[1] = ~deferred_value;
+		deferred_buffer = nullptr;
+		turag_feldbus_device_complete_deferred_answer(2);
+	}
+}
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE > 0
+// same answer as deferred_process_package(), computed in steps
+TuragFeldbusCoroutine coroutine_process_package(const uint8_t* message, FeldbusSize_t, uint8_t* response) {
+	++deferred_calls;
+	uint8_t value = message[0];
+	for (unsigned i = 0; i < deferred_idle_steps; ++i) {
+		co_await turag_feldbus_device_next_idle();
+	}
+	response[0] = value;
+	response[1] = ~value;
+	co_return 2;
+}
+
+// the main loop calls turag_feldbus_do_processing() again without a package
+void coroutine_idle() {
+	turag_feldbus_do_processing();
+}
+#endif
+
+
+std::vector<uint8_t> make_frame(const std::vector<uint8_t>& payload, FeldbusAddress_t address) {
+	std::vector<uint8_t> frame;
+	frame.reserve(payload.size() + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH + TURAG_FELDBUS_DEVICE_CRC_SIZE);
+	frame.resize(TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH);
+	turag_feldbus_device_put_address(frame.data(), address);
+	frame.insert(frame.end(), payload.begin(), payload.end());
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_XOR
+	frame.push_back(xor_checksum_calculate(frame.data(), frame.size()));
+#elif TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8
+	frame.push_back(turag_crc8_calculate(frame.data(), frame.size()));
+#elif TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+	if (turag_feldbus_device_checksum_length(frame.size()) == 1) {
+		frame.push_back(turag_crc8_calculate(frame.data(), frame.size()));
+	} else {
+		uint16_t crc = turag_crc16_calculate(frame.data(), frame.size());
+		frame.push_back(crc >> 8);
+		frame.push_back(crc & 0xff);
+	}
+#endif
+	return frame;
+}
+
+bool response_valid(const uint8_t* response, size_t length) {
+	if (length < TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH + 1) {
+		return false;
+	}
+#if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_XOR
+	return xor_checksum_check(response, length - 1, response[length - 1]);
+#elif TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8
+	return turag_crc8_check(response, length - 1, response[length - 1]);
+#elif TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+	if (length <= TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED_MAX_CRC8_LENGTH) {
+		return turag_crc8_check(response, length - 1, response[length - 1]);
+	} else {
+		return turag_crc16_check(response, length - 2, (uint16_t)(response[length - 2] << 8) | response[length - 1]);
+	}
+#endif
+}
+
+// length of a frame with data_length bytes of data
+size_t frame_length(size_t data_length) {
+	size_t length = TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH + data_length;
+	return length + turag_feldbus_device_checksum_length(length);
+}
+
+// the base device is described at compile time, the others use the string based init
+constexpr auto base_extended_info = turag_feldbus_device_make_extended_info("feldbus benchmark device", "benchmark version 1.0");
+// Protocol 0 would claim the broadcasts of the base protocol (TURAG_FELDBUS_BROADCAST_TO_ALL_DEVICES),
+// so the device answers them like a bootloader, which only speaks the base protocol.
+constexpr turag_feldbus_device_descriptor_t base_descriptor = {
+	base_extended_info.data, sizeof(base_extended_info.data), TURAG_FELDBUS_DEVICE_PROTOCOL_BOOTLOADER, 0
+};
+
+void init_device(Protocol protocol) {
+	switch (protocol) {
+	case Protocol::base:
+		turag_feldbus_device_init_descriptor(device_address, device_uuid, &base_descriptor, nullptr, nullptr);
+		break;
+
+	case Protocol::stellantriebe:
+		turag_feldbus_device_init(device_address, device_uuid,
+				"feldbus benchmark stellantrieb", "benchmark version 1.0",
+				TURAG_FELDBUS_DEVICE_PROTOCOL_STELLANTRIEBE, TURAG_FELDBUS_STELLANTRIEBE_DEVICE_TYPE_DC,
+				turag_feldbus_stellantriebe_process_package, nullptr);
+		turag_feldbus_stellantriebe_init(st_command_set, st_command_names,
+				sizeof(st_command_set) / sizeof(st_command_set[0]), nullptr);
+		break;
+
+	case Protocol::aseb:
+		turag_feldbus_device_init(device_address, device_uuid,
+				"feldbus benchmark aseb", "benchmark version 1.0",
+				TURAG_FELDBUS_DEVICE_PROTOCOL_ASEB, TURAG_FELDBUS_ASEB_GENERIC,
+				turag_feldbus_aseb_process_package, nullptr);
+		turag_feldbus_aseb_init(
+				aseb_digital_inputs, 16, aseb_digital_outputs, 8,
+				aseb_analog_inputs, 8, aseb_pwm_outputs, 2, 12);
+		break;
+
+	case Protocol::deferred:
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE > 0
+		turag_feldbus_device_init_descriptor(device_address, device_uuid, &base_descriptor,
+				deferred_process_package, nullptr);
+#endif
+		break;
+
+	case Protocol::coroutine:
+#if TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE > 0
+		turag_feldbus_device_init_descriptor(device_address, device_uuid, &base_descriptor,
+				turag_feldbus_device_coroutine_processor<coroutine_process_package>, nullptr);
+#endif
+		break;
+	}
+}
+
+inline uint64_t elapsed_ns(Clock::time_point start, Clock::time_point end) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+// Runs the transmit interrupts until the device sent its answer and checks it.
+size_t transmit(uint64_t* tx_isr_ns, std::vector<uint8_t>* answer) {
+	Clock::time_point t0 = Clock::now();
+#if TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER
+	if (turag_feldbus_sim_block_transmit_pending()) {
+		turag_feldbus_device_block_transmitted();
+	}
+#else
+	while (turag_feldbus_sim_dre_interrupt_enabled()) {
+		turag_feldbus_device_ready_to_transmit();
+	}
+	if (turag_feldbus_sim_tx_interrupt_enabled()) {
+		turag_feldbus_device_transmission_complete();
+	}
+#endif
+	*tx_isr_ns += elapsed_ns(t0, Clock::now());
+
+	uint8_t response[TURAG_FELDBUS_DEVICE_ACTUAL_BUFFER_SIZE];
+	size_t response_length = turag_feldbus_sim_read_transmitted(response, sizeof(response));
+
+	if (response_length && !response_valid(response, response_length)) {
+		fprintf(stderr, "invalid response checksum:");
+		for (size_t i = 0; i < response_length; ++i) {
+			fprintf(stderr, " %02x", response[i]);
+		}
+		fprintf(stderr, "\n");
+		exit(1);
+	}
+	if (answer) {
+		answer->assign(response, response + response_length);
+	}
+	return response_length;
+}
+
+// Runs one request/response cycle in the same order the hardware would.
+// The further packages of a segmented read are stored in segments.
+void transfer(const std::vector<uint8_t>& frame, Timing* timing, std::vector<uint8_t>* answer = nullptr,
+		std::vector<std::vector<uint8_t>>* segments = nullptr) {
+#if TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER
+	// the DMA copies the frame without any interrupt, so it is not measured
+	size_t received = turag_feldbus_sim_receive_block(frame.data(), frame.size());
+	Clock::time_point t0 = Clock::now();
+	Clock::time_point t1 = t0;
+	if (received) {
+		turag_feldbus_device_block_received(received);
+	}
+	Clock::time_point t2 = Clock::now();
+#else
+	Clock::time_point t0 = Clock::now();
+	for (uint8_t byte : frame) {
+		turag_feldbus_device_byte_received(byte);
+	}
+	Clock::time_point t1 = Clock::now();
+	turag_feldbus_device_receive_timeout_occured();
+	Clock::time_point t2 = Clock::now();
+#endif
+	turag_feldbus_do_processing();
+	uint64_t processing_ns = elapsed_ns(t2, Clock::now());
+	uint64_t tx_isr_ns = 0;
+	size_t response_length = transmit(&tx_isr_ns, answer);
+	uint64_t timeout_isr_ns = elapsed_ns(t1, t2);
+
+#if TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW
+	// the device sends the next segment once the timer started after
+	// the previous one expires
+	while (turag_feldbus_device.segment_remaining) {
+		Clock::time_point t3 = Clock::now();
+		turag_feldbus_device_receive_timeout_occured();
+		Clock::time_point t4 = Clock::now();
+		turag_feldbus_do_processing();
+		timeout_isr_ns += elapsed_ns(t3, t4);
+		processing_ns += elapsed_ns(t4, Clock::now());
+		std::vector<uint8_t> segment;
+		response_length += transmit(&tx_isr_ns, &segment);
+		if (segments) {
+			segments->push_back(segment);
+		}
+	}
+#else
+	(void)segments;
+#endif
+
+	if (timing) {
+		timing->rx_isr_ns += elapsed_ns(t0, t1);
+		timing->timeout_isr_ns += timeout_isr_ns;
+		timing->processing_ns += processing_ns;
+		timing->tx_isr_ns += tx_isr_ns;
+		timing->response_bytes += response_length;
+	}
+}
+
+// data of an answer without address and checksum
+std::vector<uint8_t> answer_data(const std::vector<uint8_t>& answer) {
+	if (answer.empty()) {
+		return answer;
+	}
+	size_t data_length = 0;
+	while (frame_length(data_length) < answer.size()) {
+		++data_length;
+	}
+	return std::vector<uint8_t>(answer.begin() + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH,
+			answer.begin() + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH + data_length);
+}
+
+// Sends a request to the device and returns the data of its answer,
+// which is empty if the device did not answer.
+std::vector<uint8_t> query(const std::vector<uint8_t>& payload) {
+	std::vector<uint8_t> answer;
+	transfer(make_frame(payload, device_address), nullptr, &answer);
+	return answer_data(answer);
+}
+
+uint64_t measure_clock_overhead() {
+	constexpr unsigned samples = 100000;
+	Clock::time_point start = Clock::now();
+	for (unsigned i = 0; i < samples; ++i) {
+		Clock::now();
+	}
+	return elapsed_ns(start, Clock::now()) / samples;
+}
+
+std::vector<uint8_t> storage_read_request(uint32_t offset, uint16_t size) {
+	std::vector<uint8_t> request = {0, TURAG_FELDBUS_DEVICE_COMMAND_READ_FROM_STATIC_STORAGE};
+	request.insert(request.end(), (uint8_t*)&offset, (uint8_t*)&offset + sizeof(offset));
+	request.insert(request.end(), (uint8_t*)&size, (uint8_t*)&size + sizeof(size));
+	return request;
+}
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER
+std::vector<uint8_t> segmented_read_request(uint8_t object, uint32_t offset, uint8_t sequence, uint8_t window) {
+	std::vector<uint8_t> request = {0, TURAG_FELDBUS_DEVICE_COMMAND_READ_SEGMENTED, object};
+	request.insert(request.end(), (uint8_t*)&offset, (uint8_t*)&offset + sizeof(offset));
+	request.push_back(sequence);
+	request.push_back(window);
+	return request;
+}
+
+// data of all packages the device sends on a segmented read
+std::vector<std::vector<uint8_t>> segmented_query(const std::vector<uint8_t>& payload) {
+	std::vector<uint8_t> answer;
+	std::vector<std::vector<uint8_t>> segments;
+	transfer(make_frame(payload, device_address), nullptr, &answer, &segments);
+	segments.insert(segments.begin(), answer);
+	for (std::vector<uint8_t>& segment : segments) {
+		segment = answer_data(segment);
+	}
+	return segments;
+}
+
+// true if the segments carry the sequence numbers from sequence on and the data of object from offset on
+bool check_segments(const std::vector<std::vector<uint8_t>>& segments, uint8_t sequence, const uint8_t* object, size_t size) {
+	constexpr size_t segment_size = TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - 1;
+	for (size_t i = 0; i < segments.size(); ++i) {
+		size_t offset = i * segment_size;
+		size_t length = offset < size ? std::min(size - offset, segment_size) : 0;
+		if (segments[i].size() != length + 1 || segments[i][0] != (uint8_t)(sequence + i) ||
+				memcmp(segments[i].data() + 1, object + offset, length) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Reads windows of the static storage and checks that a window ends with
+// the object, before the sequence number 0xff and on a new request.
+bool check_segmented_read(const std::vector<uint8_t>&, void (*)()) {
+	constexpr size_t segment_size = TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - 1;
+	constexpr uint32_t capacity = sizeof(storage);
+	for (size_t i = 0; i < sizeof(storage); ++i) {
+		storage[i] = i * 7;
+	}
+
+	std::vector<uint8_t> size = query({0, TURAG_FELDBUS_DEVICE_COMMAND_READ_SEGMENTED, TURAG_FELDBUS_DEVICE_OBJECT_STATIC_STORAGE});
+	if (size.size() != 5 || memcmp(size.data(), &capacity, sizeof(capacity)) != 0 ||
+			size[4] != (TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW ? 0xff : 1)) {
+		fprintf(stderr, "segmented read returned wrong object size\n");
+		return false;
+	}
+
+	constexpr size_t window = TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW ? 4 : 1;
+	std::vector<std::vector<uint8_t>> segments = segmented_query(
+			segmented_read_request(TURAG_FELDBUS_DEVICE_OBJECT_STATIC_STORAGE, segment_size, 1, 4));
+	if (segments.size() != window || !check_segments(segments, 1, storage + segment_size, window * segment_size)) {
+		fprintf(stderr, "segmented read returned a wrong window\n");
+		return false;
+	}
+
+	// the last segment is short and ends the window
+	uint32_t offset = capacity - segment_size - 10;
+	segments = segmented_query(segmented_read_request(TURAG_FELDBUS_DEVICE_OBJECT_STATIC_STORAGE, offset, 0, 4));
+	if (segments.size() != std::min<size_t>(window, 2) || !check_segments(segments, 0, storage + offset, capacity - offset)) {
+		fprintf(stderr, "segmented read did not end with the object\n");
+		return false;
+	}
+
+	segments = segmented_query(segmented_read_request(TURAG_FELDBUS_DEVICE_OBJECT_STATIC_STORAGE, 0, 0xfd, 4));
+	if (segments.size() != std::min<size_t>(window, 2) || !check_segments(segments, 0xfd, storage, capacity)) {
+		fprintf(stderr, "segmented read used sequence number 0xff\n");
+		return false;
+	}
+
+#if TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW
+	// the master interrupts the window after the first segment
+	for (uint8_t byte : make_frame(segmented_read_request(TURAG_FELDBUS_DEVICE_OBJECT_STATIC_STORAGE, 0, 0, 4), device_address)) {
+		turag_feldbus_device_byte_received(byte);
+	}
+	turag_feldbus_device_receive_timeout_occured();
+	turag_feldbus_do_processing();
+	uint64_t tx_isr_ns = 0;
+	transmit(&tx_isr_ns, nullptr);
+	turag_feldbus_do_processing();
+	if (turag_feldbus_device.segment_remaining == 0 || turag_feldbus_sim_dre_interrupt_enabled()) {
+		fprintf(stderr, "segmented read did not wait for the gap\n");
+		return false;
+	}
+	if (query({0, TURAG_FELDBUS_DEVICE_COMMAND_GET_UUID}).size() != sizeof(device_uuid) || turag_feldbus_device.segment_remaining) {
+		fprintf(stderr, "segmented read was not cancelled by a new request\n");
+		return false;
+	}
+#endif
+	return true;
+}
+
+
+// Checks that the name which is truncated by the command info is complete
+// when read as object, the way a master continues behind the last segment.
+bool check_command_name_segmented(const std::vector<uint8_t>&, void (*)()) {
+	constexpr uint8_t object = TURAG_FELDBUS_STELLANTRIEBE_OBJECT_COMMAND_NAME + st_long_name_key - 1;
+	const char* name = st_command_names[st_long_name_key - 1];
+	std::vector<uint8_t> truncated = query({st_long_name_key, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_INFO_GET_NAME, 0, 0});
+	if (strlen(name) <= TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE || truncated.size() >= strlen(name)) {
+		fprintf(stderr, "command name fits into a package\n");
+		return false;
+	}
+
+	std::string read;
+	uint8_t sequence = 0;
+	bool complete = false;
+	while (!complete) {
+		for (const std::vector<uint8_t>& segment : segmented_query(segmented_read_request(object, read.size(), sequence, 2))) {
+			if (segment.empty() || segment[0] != sequence) {
+				fprintf(stderr, "command name segment has a wrong sequence number\n");
+				return false;
+			}
+			++sequence;
+			read.append(segment.begin() + 1, segment.end());
+			complete = segment.size() < TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE;
+		}
+	}
+	if (read != name) {
+		fprintf(stderr, "segmented command name is \"%s\"\n", read.c_str());
+		return false;
+	}
+	return true;
+}
+#endif
+
+// largest answer of a packet processor, the address of the answer uses the rest of the buffer
+constexpr size_t st_response_limit = TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH;
+// largest structured output st_structure() builds without exceeding the table
+constexpr size_t st_structure_limit = std::min(st_response_limit, (size_t)4 * (TURAG_FELDBUS_STELLANTRIEBE_STRUCTURED_OUTPUT_BUFFER_SIZE - 2) + 3);
+
+// structure table whose structured output has the given size
+std::vector<uint8_t> st_structure(size_t size) {
+	std::vector<uint8_t> request = {TURAG_FELDBUS_STELLANTRIEBE_STRUCTURED_OUTPUT_GET, TURAG_FELDBUS_STELLANTRIEBE_STRUCTURED_OUTPUT_SET_STRUCTURE};
+	for (; size >= 4; size -= 4) {
+		request.push_back(1);
+	}
+	if (size >= 2) {
+		request.push_back(2);
+		size -= 2;
+	}
+	if (size) {
+		request.push_back(3);
+	}
+	return request;
+}
+
+// Checks that the answers of the command set use the whole buffer beside
+// the address, so they also fit with TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH == 2.
+bool check_structured_output_full(const std::vector<uint8_t>& frame, void (*)()) {
+	std::vector<uint8_t> answer;
+	transfer(frame, nullptr, &answer);
+	if (answer.size() != frame_length(st_structure_limit) ||
+			turag_feldbus_device_get_address(answer.data()) != (TURAG_FELDBUS_DEVICE_MASTER_ADDR | device_address)) {
+		fprintf(stderr, "structured output does not fill the buffer\n");
+		return false;
+	}
+	// with large buffers the table is full before the buffer
+	if (st_structure_limit == st_response_limit &&
+			query(st_structure(st_response_limit + 1)) != std::vector<uint8_t>{TURAG_FELDBUS_STELLANTRIEBE_STRUCTURED_OUTPUT_TABLE_REJECTED}) {
+		fprintf(stderr, "structured output larger than the buffer was accepted\n");
+		return false;
+	}
+	if (query(st_structure(st_structure_limit)) != std::vector<uint8_t>{TURAG_FELDBUS_STELLANTRIEBE_STRUCTURED_OUTPUT_TABLE_OK}) {
+		fprintf(stderr, "structured output that fits into the buffer was rejected\n");
+		return false;
+	}
+
+	// the long command name is cut off at the same size
+	if (query({st_long_name_key, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_INFO_GET_NAME, 0, 0}).size() != st_response_limit) {
+		fprintf(stderr, "command name is not cut off at the end of the buffer\n");
+		return false;
+	}
+	return true;
+}
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH
+std::vector<uint8_t> storage_hash_request(uint8_t algorithm, uint32_t offset, uint32_t length) {
+	std::vector<uint8_t> request = {0, TURAG_FELDBUS_DEVICE_COMMAND_HASH_STATIC_STORAGE, algorithm};
+	request.insert(request.end(), (uint8_t*)&offset, (uint8_t*)&offset + sizeof(offset));
+	request.insert(request.end(), (uint8_t*)&length, (uint8_t*)&length + sizeof(length));
+	return request;
+}
+#endif
+
+std::vector<uint8_t> storage_write_request(uint32_t offset, uint16_t size) {
+	std::vector<uint8_t> request = {0, TURAG_FELDBUS_DEVICE_COMMAND_WRITE_TO_STATIC_STORAGE};
+	request.insert(request.end(), (uint8_t*)&offset, (uint8_t*)&offset + sizeof(offset));
+	for (uint16_t i = 0; i < size; ++i) {
+		request.push_back(i);
+	}
+	return request;
+}
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS
+// broadcast that assigns an address to the device with our UUID
+std::vector<uint8_t> set_address_broadcast(FeldbusAddress_t address) {
+	std::vector<uint8_t> request = {TURAG_FELDBUS_BROADCAST_TO_ALL_DEVICES, TURAG_FELDBUS_DEVICE_BROADCAST_UUID,
+			(uint8_t)device_uuid, (uint8_t)(device_uuid >> 8), (uint8_t)(device_uuid >> 16), (uint8_t)(device_uuid >> 24),
+			TURAG_FELDBUS_DEVICE_BROADCAST_UUID_ADDRESS};
+	request.resize(request.size() + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH);
+	turag_feldbus_device_put_address(request.data() + request.size() - TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH, address);
+	return request;
+}
+
+// true if the device answers a ping sent to this address
+bool ping(FeldbusAddress_t address) {
+	std::vector<uint8_t> answer;
+	transfer(make_frame({}, address), nullptr, &answer);
+	return !answer.empty();
+}
+
+// Checks that an assigned address survives a reset and that assigning
+// the same address again does not write the storage.
+bool check_persistent_address(const std::vector<uint8_t>& frame, void (*)()) {
+	std::vector<uint8_t> answer;
+	transfer(make_frame(set_address_broadcast(foreign_address), TURAG_FELDBUS_DEVICE_BROADCAST_ADDR), nullptr, &answer);
+	if (answer.size() != frame_length(1) || answer[TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH] != 1) {
+		fprintf(stderr, "address was not assigned\n");
+		return false;
+	}
+
+	init_device(Protocol::base);
+	if (!ping(foreign_address) || ping(device_address)) {
+		fprintf(stderr, "assigned address was not restored\n");
+		return false;
+	}
+
+	// assign the address of the other benchmarks again, once with a write and once without
+	const unsigned writes = storage_writes;
+	transfer(frame, nullptr);
+	transfer(frame, nullptr);
+	if (storage_writes != writes + 1 || !ping(device_address)) {
+		fprintf(stderr, "assigning the same address again wrote the storage\n");
+		return false;
+	}
+	return true;
+}
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE
+// the main loop finishes the write while the master polls its state
+void storage_write_idle() {
+	while (query({0, TURAG_FELDBUS_DEVICE_COMMAND_STATIC_STORAGE_STATUS}) == std::vector<uint8_t>{TURAG_FELDBUS_DEVICE_STORAGE_BUSY}) {
+		turag_feldbus_do_processing();
+	}
+}
+
+// Checks that a write is answered before it is programmed and that the storage
+// is busy until the main loop finished it.
+bool check_async_storage_write(const std::vector<uint8_t>&, void (*)()) {
+	const std::vector<uint8_t> busy = {TURAG_FELDBUS_DEVICE_STORAGE_BUSY};
+	memset(storage, 0xff, sizeof(storage));
+
+	if (query(storage_write_request(0, storage_transfer_size)) != std::vector<uint8_t>{0} || storage[1] != 0xff) {
+		fprintf(stderr, "write to static storage was not answered before programming\n");
+		return false;
+	}
+	std::vector<uint8_t> read = query(storage_read_request(0, 1));
+	if (query({0, TURAG_FELDBUS_DEVICE_COMMAND_STATIC_STORAGE_STATUS}) != busy ||
+			query(storage_write_request(0, 1)) != busy || read.empty() || read[0] != busy[0]) {
+		fprintf(stderr, "static storage was not busy during the write\n");
+		return false;
+	}
+
+	// start and finish the write
+	turag_feldbus_do_processing();
+	turag_feldbus_do_processing();
+	if (query({0, TURAG_FELDBUS_DEVICE_COMMAND_STATIC_STORAGE_STATUS}) != std::vector<uint8_t>{0}) {
+		fprintf(stderr, "write to static storage did not finish\n");
+		return false;
+	}
+	for (uint16_t i = 0; i < storage_transfer_size; ++i) {
+		if (storage[i] != (uint8_t)i) {
+			fprintf(stderr, "write to static storage programmed wrong data at %u\n", i);
+			return false;
+		}
+	}
+	return true;
+}
+#else
+// writes are finished before they are answered
+constexpr void (*storage_write_idle)() = nullptr;
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH > 0
+// frame of a bulk write, each byte holds the low byte of its storage offset
+std::vector<uint8_t> bulk_write_request(uint8_t sequence, uint32_t offset, uint16_t size) {
+	std::vector<uint8_t> request = {0, TURAG_FELDBUS_DEVICE_COMMAND_BULK_WRITE, sequence};
+	request.insert(request.end(), (uint8_t*)&offset, (uint8_t*)&offset + sizeof(offset));
+	for (uint16_t i = 0; i < size; ++i) {
+		request.push_back(offset + i);
+	}
+	return request;
+}
+
+// starts and finishes programming the frame and starts a new transfer,
+// so the next frame is accepted again
+void bulk_write_idle() {
+	turag_feldbus_do_processing();
+	turag_feldbus_do_processing();
+	query({0, TURAG_FELDBUS_DEVICE_COMMAND_BULK_WRITE, 0});
+}
+
+// Sends one frame more than the queue holds and checks that the main loop
+// programs the queued ones in order while the last one is dropped. Until the
+// queue is empty the other storage requests have to wait.
+bool check_bulk_write(const std::vector<uint8_t>&, void (*)()) {
+	constexpr uint8_t queue_length = TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH;
+	constexpr uint16_t size = storage_transfer_size - 1;
+	// the sequence numbers wrap around
+	constexpr uint8_t first = 0xfe;
+	constexpr uint8_t last = (uint8_t)(first + queue_length);
+	memset(storage, 0, sizeof(storage));
+
+	if (query({0, TURAG_FELDBUS_DEVICE_COMMAND_BULK_WRITE, first}) != std::vector<uint8_t>{first, first, queue_length, 0}) {
+		fprintf(stderr, "bulk write was not started\n");
+		return false;
+	}
+	for (uint8_t i = 0; i <= queue_length; ++i) {
+		if (!query(bulk_write_request(first + i, i * size, size)).empty()) {
+			fprintf(stderr, "bulk write frame was answered\n");
+			return false;
+		}
+	}
+	if (query({0, TURAG_FELDBUS_DEVICE_COMMAND_BULK_WRITE}) != std::vector<uint8_t>{last, first, 0, 0}) {
+		fprintf(stderr, "bulk write frames were not queued\n");
+		return false;
+	}
+
+	const std::vector<uint8_t> busy = {TURAG_FELDBUS_DEVICE_STORAGE_BUSY};
+	std::vector<uint8_t> read = query(storage_read_request(0, 1));
+	if (query(storage_write_request(0, 1)) != busy || read.empty() || read[0] != busy[0]) {
+		fprintf(stderr, "static storage was not busy with queued bulk write frames\n");
+		return false;
+	}
+#if TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH
+	if (query(storage_hash_request(TURAG_FELDBUS_DEVICE_HASH_CRC16, 0, 1)) != busy) {
+		fprintf(stderr, "storage hash was not busy with queued bulk write frames\n");
+		return false;
+	}
+#endif
+
+	// each frame is started and finished in its own step
+	turag_feldbus_do_processing();
+	if (query({0, TURAG_FELDBUS_DEVICE_COMMAND_BULK_WRITE, first}) !=
+			std::vector<uint8_t>{last, first, 0, TURAG_FELDBUS_DEVICE_STORAGE_BUSY}) {
+		fprintf(stderr, "bulk write was restarted while programming a frame\n");
+		return false;
+	}
+	for (uint8_t i = 1; i < 2 * queue_length; ++i) {
+		turag_feldbus_do_processing();
+	}
+	if (query({0, TURAG_FELDBUS_DEVICE_COMMAND_BULK_WRITE}) != std::vector<uint8_t>{last, last, queue_length, 0}) {
+		fprintf(stderr, "bulk write frames were not programmed\n");
+		return false;
+	}
+	for (uint32_t i = 0; i < sizeof(storage); ++i) {
+		if (storage[i] != (i < queue_length * size ? (uint8_t)i : 0)) {
+			fprintf(stderr, "bulk write programmed wrong data at %u\n", i);
+			return false;
+		}
+	}
+	return true;
+}
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+// Checks that every request is recorded in the profile of the processing stage
+// and that a reset clears it.
+bool check_profile(const std::vector<uint8_t>&, void (*)()) {
+	constexpr unsigned requests = 10;
+	constexpr size_t buckets = TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKETS;
+
+	if (query({0, TURAG_FELDBUS_DEVICE_COMMAND_GET_PROFILE}) != std::vector<uint8_t>{
+			TURAG_FELDBUS_DEVICE_PROFILE_STAGE_COUNT, buckets, TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKET_SHIFT}) {
+		fprintf(stderr, "wrong profile layout\n");
+		return false;
+	}
+
+	// the reset itself is recorded after it cleared the profile
+	query({0, TURAG_FELDBUS_DEVICE_COMMAND_RESET_PROFILE});
+	for (unsigned i = 0; i < requests; ++i) {
+		query({});
+	}
+	std::vector<uint8_t> profile = query({0, TURAG_FELDBUS_DEVICE_COMMAND_GET_PROFILE, TURAG_FELDBUS_DEVICE_PROFILE_PROCESSING});
+	if (profile.size() != 8 + 2 * buckets) {
+		fprintf(stderr, "wrong length of the profile of a stage\n");
+		return false;
+	}
+	uint32_t min, max;
+	memcpy(&min, profile.data(), sizeof(min));
+	memcpy(&max, profile.data() + 4, sizeof(max));
+	unsigned count = 0;
+	for (size_t i = 0; i < buckets; ++i) {
+		uint16_t bucket;
+		memcpy(&bucket, profile.data() + 8 + 2 * i, sizeof(bucket));
+		count += bucket;
+	}
+	if (count != requests + 1 || min > max) {
+		fprintf(stderr, "profile recorded %u of %u requests\n", count, requests + 1);
+		return false;
+	}
+	return true;
+}
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+// first counter of a group of the traffic statistics
+uint16_t statistics_counter(uint8_t group, uint8_t index) {
+	std::vector<uint8_t> counters = query({0, TURAG_FELDBUS_DEVICE_COMMAND_GET_STATISTICS, group, index});
+	uint16_t counter = 0xffff;
+	if (counters.size() >= sizeof(counter)) {
+		memcpy(&counter, counters.data(), sizeof(counter));
+	}
+	return counter;
+}
+
+// Checks the traffic statistics after a reset and a few requests of each kind.
+bool check_statistics(const std::vector<uint8_t>& frame, void (*)()) {
+	const std::vector<uint8_t> requests[] = {
+		make_frame({0, TURAG_FELDBUS_DEVICE_COMMAND_GET_UUID}, device_address),
+		make_frame({0}, device_address),
+		make_frame({1, 2, 3}, device_address),
+	};
+	const std::vector<uint8_t> foreign = make_frame({0, TURAG_FELDBUS_DEVICE_COMMAND_GET_UUID}, foreign_address);
+	std::vector<uint8_t> answer;
+
+	// the answer to the reset is already counted
+	transfer(make_frame({0, TURAG_FELDBUS_DEVICE_COMMAND_RESET_PACKAGE_COUNT}, device_address), nullptr, &answer);
+	uint32_t tx_bytes = answer.size();
+	uint32_t rx_bytes = frame.size();
+	for (const std::vector<uint8_t>& request : requests) {
+		transfer(request, nullptr, &answer);
+		rx_bytes += request.size();
+		tx_bytes += answer.size();
+	}
+	// counted as received as well
+	transfer(foreign, nullptr);
+	rx_bytes += foreign.size();
+
+	std::vector<uint8_t> statistics = query({0, TURAG_FELDBUS_DEVICE_COMMAND_GET_STATISTICS});
+	std::vector<uint8_t> expected(18);
+	const uint32_t foreign_bytes = foreign.size();
+	const uint16_t broadcasts = 0;
+	const uint16_t other_reserved = 1;
+	memcpy(expected.data(), &rx_bytes, 4);
+	memcpy(expected.data() + 4, &tx_bytes, 4);
+	memcpy(expected.data() + 8, &foreign_bytes, 4);
+	memcpy(expected.data() + 12, &broadcasts, 2);
+	memcpy(expected.data() + 14, &other_reserved, 2);
+	expected[16] = TURAG_FELDBUS_DEVICE_STATISTICS_RESERVED_COUNT;
+	expected[17] = TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS_COMMANDS;
+	if (statistics != expected) {
+		fprintf(stderr, "wrong traffic statistics\n");
+		return false;
+	}
+
+	if (statistics_counter(TURAG_FELDBUS_DEVICE_STATISTICS_RESERVED, TURAG_FELDBUS_DEVICE_COMMAND_GET_UUID) != 1 ||
+			statistics_counter(TURAG_FELDBUS_DEVICE_STATISTICS_PROTOCOL, 1) != 1 ||
+			statistics_counter(TURAG_FELDBUS_DEVICE_STATISTICS_RESERVED, TURAG_FELDBUS_DEVICE_COMMAND_GET_STATISTICS) != 4) {
+		fprintf(stderr, "wrong packet counters\n");
+		return false;
+	}
+	return true;
+}
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+// Checks that the trace records requests with their result in the order they happened.
+bool check_trace(const std::vector<uint8_t>&, void (*)()) {
+	constexpr size_t entry_size = 8;
+	constexpr size_t max_entries = (TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - 1) / entry_size;
+	std::vector<uint8_t> trace;
+
+	// only the answer to the last request remains
+	do {
+		trace = query({0, TURAG_FELDBUS_DEVICE_COMMAND_READ_TRACE});
+	} while (trace.size() == 1 + max_entries * entry_size);
+
+	std::vector<uint8_t> corrupted = make_frame({0, TURAG_FELDBUS_DEVICE_COMMAND_GET_UUID}, device_address);
+	corrupted.back() ^= 0xff;
+	query({0, TURAG_FELDBUS_DEVICE_COMMAND_GET_UUID});
+	query({1, 2, 3});
+	transfer(corrupted, nullptr);
+	trace = query({0, TURAG_FELDBUS_DEVICE_COMMAND_READ_TRACE});
+
+	const std::vector<uint8_t> events = {
+		TURAG_FELDBUS_DEVICE_TRACE_ANSWERED,
+		TURAG_FELDBUS_DEVICE_TRACE_RECEIVED, TURAG_FELDBUS_DEVICE_TRACE_ANSWERED,
+		TURAG_FELDBUS_DEVICE_TRACE_RECEIVED, TURAG_FELDBUS_DEVICE_TRACE_NO_ANSWER,
+#if !TURAG_FELDBUS_DEVICE_CONFIG_RX_CHECKSUM_IN_ISR
+		TURAG_FELDBUS_DEVICE_TRACE_RECEIVED,
+#endif
+		TURAG_FELDBUS_DEVICE_TRACE_CHECKSUM_ERROR,
+		TURAG_FELDBUS_DEVICE_TRACE_RECEIVED,
+	};
+	if (trace.size() != 1 + events.size() * entry_size || trace[0] != 0) {
+		fprintf(stderr, "trace has %zu bytes instead of %zu entries\n", trace.size(), events.size());
+		return false;
+	}
+	for (size_t i = 0; i < events.size(); ++i) {
+		if (trace[1 + i * entry_size + 3] != events[i]) {
+			fprintf(stderr, "trace entry %zu has event %u instead of %u\n", i, trace[1 + i * entry_size + 3], events[i]);
+			return false;
+		}
+	}
+	// the answer to the UUID request
+	const uint8_t* answered = trace.data() + 1 + 2 * entry_size;
+	if (answered[2] != sizeof(device_uuid) || memcmp(answered + 4, &device_uuid, sizeof(device_uuid)) != 0) {
+		fprintf(stderr, "trace does not contain the answer\n");
+		return false;
+	}
+	return true;
+}
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED
+// reads the log until it is empty and returns the dropped count of the first read
+static unsigned drain_log() {
+	std::vector<uint8_t> log = query({0, TURAG_FELDBUS_DEVICE_COMMAND_READ_LOG});
+	unsigned dropped = log.empty() ? 0 : log[0];
+	while (log.size() > 1) {
+		log = query({0, TURAG_FELDBUS_DEVICE_COMMAND_READ_LOG});
+	}
+	return dropped;
+}
+
+bool check_log(const std::vector<uint8_t>&, void (*)()) {
+	drain_log();
+
+	print_text("bench");
+	print_char(0x12);
+	print_short(0x3456);
+	print_slong(-2);
+	const std::vector<uint8_t> expected = {0,
+		TURAG_FELDBUS_DEVICE_LOG_TEXT, 5, 'b', 'e', 'n', 'c', 'h',
+		TURAG_FELDBUS_DEVICE_LOG_CHAR, 0x12,
+		TURAG_FELDBUS_DEVICE_LOG_SHORT, 0x56, 0x34,
+		TURAG_FELDBUS_DEVICE_LOG_SLONG, 0xfe, 0xff, 0xff, 0xff};
+	if (query({0, TURAG_FELDBUS_DEVICE_COMMAND_READ_LOG}) != expected) {
+		fprintf(stderr, "log does not contain the printed records\n");
+		return false;
+	}
+
+	// one byte of the ring stays free, every long record takes five
+	constexpr unsigned fitting = (TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_LOG_SIZE - 1) / 5;
+	for (unsigned i = 0; i < fitting + 3; ++i) {
+		print_long(i);
+	}
+	unsigned dropped = drain_log();
+	if (dropped != 3) {
+		fprintf(stderr, "log dropped %u records instead of 3\n", dropped);
+		return false;
+	}
+	if (query({0, TURAG_FELDBUS_DEVICE_COMMAND_READ_LOG}) != std::vector<uint8_t>{0}) {
+		fprintf(stderr, "log is not empty after reading\n");
+		return false;
+	}
+	return true;
+}
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE > 0
+// Repeats a deferred request until its answer arrives. Afterwards no answer is
+// deferred, so the next benchmark can defer its own.
+bool collect_deferred_answer(const std::vector<uint8_t>& frame, void (*idle)()) {
+	std::vector<uint8_t> answer;
+	for (unsigned i = 0; i <= deferred_idle_steps + 1; ++i) {
+		idle();
+		transfer(frame, nullptr, &answer);
+		if (answer.size() == frame_length(2)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Checks the life cycle of a deferred answer: the request and its repetitions get an
+// empty answer until idle() completed it, then the answer is sent once and the
+// next repetition reaches the packet processor again.
+bool check_deferred_answer(const std::vector<uint8_t>& frame, void (*idle)()) {
+	const uint8_t value = frame[TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH];
+	const unsigned calls = deferred_calls;
+	std::vector<uint8_t> answer;
+
+	transfer(frame, nullptr, &answer);
+	if (deferred_calls != calls + 1 || answer.size() != frame_length(0)) {
+		fprintf(stderr, "deferred request was not answered with an empty package\n");
+		return false;
+	}
+	for (unsigned i = 1; i < deferred_idle_steps; ++i) {
+		idle();
+		transfer(frame, nullptr, &answer);
+		if (deferred_calls != calls + 1 || answer.size() != frame_length(0)) {
+			fprintf(stderr, "repetition of a pending request was not answered with an empty package\n");
+			return false;
+		}
+	}
+
+	idle();
+	transfer(frame, nullptr, &answer);
+	if (deferred_calls != calls + 1 || answer.size() != frame_length(2) ||
+			answer[TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH] != value ||
+			answer[TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH + 1] != (uint8_t)~value) {
+		fprintf(stderr, "deferred answer was not sent\n");
+		return false;
+	}
+
+	transfer(frame, nullptr, &answer);
+	if (deferred_calls != calls + 2 || answer.size() != frame_length(0)) {
+		fprintf(stderr, "repetition after the deferred answer did not reach the packet processor\n");
+		return false;
+	}
+
+	return collect_deferred_answer(frame, idle);
+}
+#endif
+
+std::vector<Benchmark> make_benchmarks() {
+	std::vector<uint8_t> structure = {TURAG_FELDBUS_STELLANTRIEBE_STRUCTURED_OUTPUT_GET, TURAG_FELDBUS_STELLANTRIEBE_STRUCTURED_OUTPUT_SET_STRUCTURE};
+	for (uint8_t key = 1; key <= 20; ++key) {
+		structure.push_back(key);
+	}
+
+	return {
+		{"base.ping", Protocol::base, false, {}, {}},
+		{"base.device_info", Protocol::base, false, {0}, {}},
+		{"base.device_name", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_DEVICE_NAME}, {}},
+		{"base.uptime_counter", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_UPTIME_COUNTER}, {}},
+		{"base.versioninfo", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_VERSIONINFO}, {}},
+		{"base.package_count_correct", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_CORRECT}, {}},
+		{"base.package_count_bufferoverflow", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_BUFFEROVERFLOW}, {}},
+		{"base.package_count_lost", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_LOST}, {}},
+		{"base.package_count_chksum_mismatch", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_CHKSUM_MISMATCH}, {}},
+		{"base.package_count_all", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_ALL}, {}},
+		{"base.reset_package_count", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_RESET_PACKAGE_COUNT}, {}},
+		{"base.get_uuid", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_GET_UUID}, {}},
+		{"base.get_extended_info", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_GET_EXTENDED_INFO}, {}},
+		{"base.get_static_storage_capacity", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_GET_STATIC_STORAGE_CAPACITY}, {}},
+		{"base.read_from_static_storage", Protocol::base, false, storage_read_request(0, storage_transfer_size), {}},
+		{"base.write_to_static_storage", Protocol::base, false, storage_write_request(0, storage_transfer_size), {}, false, storage_write_idle},
+#if TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE
+		{"base.static_storage_status", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_STATIC_STORAGE_STATUS}, {}, false, nullptr, check_async_storage_write},
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER
+		{"base.read_segmented_storage", Protocol::base, false, segmented_read_request(TURAG_FELDBUS_DEVICE_OBJECT_STATIC_STORAGE, 0, 0, 4), {},
+				false, nullptr, check_segmented_read},
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH > 0
+		{"base.bulk_write_status", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_BULK_WRITE}, {}, false, nullptr, check_bulk_write},
+		// the frame is not answered, idle() programs it and restarts the transfer
+		{"base.bulk_write_frame", Protocol::base, false, bulk_write_request(0, 0, storage_transfer_size - 1),
+				{{0, TURAG_FELDBUS_DEVICE_COMMAND_BULK_WRITE, 0}}, false, bulk_write_idle},
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+		{"base.get_profile", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_GET_PROFILE}, {}, false, nullptr, check_profile},
+		{"base.get_profile_stage", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_GET_PROFILE, TURAG_FELDBUS_DEVICE_PROFILE_PROCESSING}, {}},
+		{"base.reset_profile", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_RESET_PROFILE}, {}},
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+		{"base.get_statistics", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_GET_STATISTICS}, {}, false, nullptr, check_statistics},
+		{"base.get_statistics_counters", Protocol::base, false,
+				{0, TURAG_FELDBUS_DEVICE_COMMAND_GET_STATISTICS, TURAG_FELDBUS_DEVICE_STATISTICS_RESERVED, 0}, {}},
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+		{"base.read_trace", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_READ_TRACE}, {}, false, nullptr, check_trace},
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED
+		{"base.read_log", Protocol::base, false, {0, TURAG_FELDBUS_DEVICE_COMMAND_READ_LOG}, {}, false, nullptr, check_log},
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH
+		{"base.hash_static_storage_crc16", Protocol::base, false,
+				storage_hash_request(TURAG_FELDBUS_DEVICE_HASH_CRC16, 0, TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH_MAX_LENGTH), {}},
+		{"base.hash_static_storage_murmur3", Protocol::base, false,
+				storage_hash_request(TURAG_FELDBUS_DEVICE_HASH_MURMUR3, 0, TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH_MAX_LENGTH), {}},
+#endif
+		{"base.foreign_package", Protocol::base, false, storage_write_request(0, storage_transfer_size), {}, true},
+		{"base.broadcast_uuid_ping", Protocol::base, true, {TURAG_FELDBUS_BROADCAST_TO_ALL_DEVICES, TURAG_FELDBUS_DEVICE_BROADCAST_UUID,
+				(uint8_t)device_uuid, (uint8_t)(device_uuid >> 8), (uint8_t)(device_uuid >> 16), (uint8_t)(device_uuid >> 24)}, {}},
+#if TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS
+		{"base.broadcast_set_address", Protocol::base, true, set_address_broadcast(device_address), {}, false, nullptr, check_persistent_address},
+#endif
+
+		{"stellantriebe.read_char", Protocol::stellantriebe, false, {3}, {}},
+		{"stellantriebe.read_long", Protocol::stellantriebe, false, {1}, {}},
+		{"stellantriebe.write_short", Protocol::stellantriebe, false, {2, 0x34, 0x12}, {}},
+		{"stellantriebe.write_long", Protocol::stellantriebe, false, {1, 0x78, 0x56, 0x34, 0x12}, {}},
+		{"stellantriebe.command_info", Protocol::stellantriebe, false, {1, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_INFO_GET, 0, 0}, {}},
+		{"stellantriebe.command_name", Protocol::stellantriebe, false, {1, TURAG_FELDBUS_STELLANTRIEBE_COMMAND_INFO_GET_NAME, 0, 0}, {}},
+#if TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER
+		{"stellantriebe.command_name_segmented", Protocol::stellantriebe, false,
+				segmented_read_request(TURAG_FELDBUS_STELLANTRIEBE_OBJECT_COMMAND_NAME + st_long_name_key - 1, 0, 0, 2), {},
+				false, nullptr, check_command_name_segmented},
+#endif
+		{"stellantriebe.set_structure", Protocol::stellantriebe, false, structure, {}},
+		{"stellantriebe.structured_output", Protocol::stellantriebe, false, {TURAG_FELDBUS_STELLANTRIEBE_STRUCTURED_OUTPUT_GET}, {structure}},
+		// run with -DTURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH=2 for the 2-byte address
+		{"stellantriebe.structured_output_full", Protocol::stellantriebe, false, {TURAG_FELDBUS_STELLANTRIEBE_STRUCTURED_OUTPUT_GET},
+				{st_structure(st_structure_limit)}, false, nullptr, check_structured_output_full},
+
+		{"aseb.sync", Protocol::aseb, false, {TURAG_FELDBUS_ASEB_SYNC}, {}},
+		{"aseb.set_digital_output", Protocol::aseb, false, {TURAG_FELDBUS_ASEB_INDEX_START_DIGITAL_OUTPUT, 1}, {}},
+		{"aseb.get_pwm_output", Protocol::aseb, false, {TURAG_FELDBUS_ASEB_INDEX_START_PWM_OUTPUT}, {}},
+		{"aseb.set_pwm_output", Protocol::aseb, false, {TURAG_FELDBUS_ASEB_INDEX_START_PWM_OUTPUT, 0xf4, 0x01}, {}},
+		{"aseb.channel_name", Protocol::aseb, false, {TURAG_FELDBUS_ASEB_CHANNEL_NAME, TURAG_FELDBUS_ASEB_INDEX_START_ANALOG_INPUT}, {}},
+		{"aseb.sync_size", Protocol::aseb, false, {TURAG_FELDBUS_ASEB_SYNC_SIZE}, {}},
+
+		// one request and its repetitions: deferred, pending, answered
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE > 0
+		{"deferred.answer", Protocol::deferred, false, {0x5a}, {}, false, deferred_idle, check_deferred_answer, collect_deferred_answer},
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE > 0
+		{"coroutine.next_idle", Protocol::coroutine, false, {0x5a}, {}, false, coroutine_idle, check_deferred_answer, collect_deferred_answer},
+#endif
+	};
+}
+
+void print_usage(const char* name) {
+	fprintf(stderr, "usage: %s [--iterations N] [--baudrate B] [--filter SUBSTRING] [--stress SECONDS]\n", name);
+}
+
+
+/*
+ * stress test
+ */
+struct StressRequest {
+	std::vector<uint8_t> payload;
+	// length of each answer without address and checksum
+	size_t response_length;
+	// number of answers, a segmented read sends several
+	unsigned answers = 1;
+};
+
+// Reads one answer from the bus. Returns false if it does not arrive in time.
+bool read_answer(int fd, uint8_t* buffer, size_t length) {
+	size_t received = 0;
+	while (received < length) {
+		pollfd pfd = { fd, POLLIN, 0 };
+		if (poll(&pfd, 1, 100) <= 0) {
+			return false;
+		}
+		ssize_t result = read(fd, buffer + received, length - received);
+		if (result <= 0) {
+			return false;
+		}
+		received += result;
+	}
+	return true;
+}
+
+// Lets the simulated interrupt controller and a main loop calling
+// turag_feldbus_do_processing() run on separate threads while the bus
+// master sends requests as fast as possible. Packages to other devices are
+// mixed in, so that the receive interrupt runs while the main loop is busy.
+// Every request must be answered correctly and no package must get lost.
+int run_stress(unsigned long seconds, unsigned long baudrate) {
+	turag_feldbus_sim_config_t config;
+	turag_feldbus_sim_default_config(&config);
+	config.baudrate = baudrate;
+	if (turag_feldbus_sim_open(&config) != 0) {
+		perror("turag_feldbus_sim_open");
+		return 1;
+	}
+	init_device(Protocol::base);
+
+	std::atomic<bool> stop(false);
+	std::thread main_loop([&stop] {
+		while (!stop.load(std::memory_order_relaxed)) {
+			turag_feldbus_do_processing();
+		}
+	});
+
+	const std::vector<StressRequest> requests = {
+		{{}, 0},
+		{{0}, 11},
+		{{0, TURAG_FELDBUS_DEVICE_COMMAND_DEVICE_NAME}, base_extended_info.data[1]},
+		{{0, TURAG_FELDBUS_DEVICE_COMMAND_UPTIME_COUNTER}, 4},
+		{{0, TURAG_FELDBUS_DEVICE_COMMAND_GET_UUID}, 4},
+#if TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER
+		{segmented_read_request(TURAG_FELDBUS_DEVICE_OBJECT_STATIC_STORAGE, 0, 0, 2), TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE,
+				TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW ? 2u : 1u},
+#endif
+	};
+	const std::vector<uint8_t> foreign_frame = make_frame({0, TURAG_FELDBUS_DEVICE_COMMAND_GET_UUID}, foreign_address);
+	// the master leaves the bus idle for at least the receive timeout between two packages
+	const uint64_t gap_ns = 2 * turag_feldbus_sim_bus_time_ns(2, baudrate);
+
+	int fd = turag_feldbus_sim_bus_fd();
+	// bytes the device received or dropped
+	auto rx_bytes = [] {
+		turag_feldbus_sim_stats_t stats;
+		turag_feldbus_sim_get_stats(&stats);
+		return (size_t)stats.rx_bytes + stats.rx_dropped;
+	};
+	size_t expected_rx_bytes = 0;
+	unsigned long sent = 0;
+	unsigned long failures = 0;
+	Clock::time_point end = Clock::now() + std::chrono::seconds(seconds);
+
+	while (Clock::now() < end && failures < 10) {
+		const StressRequest& request = requests[sent % requests.size()];
+
+		if (sent % 3 == 0) {
+			if (write(fd, foreign_frame.data(), foreign_frame.size()) != (ssize_t)foreign_frame.size()) {
+				++failures;
+				break;
+			}
+			// the simulation only knows when it read the bytes, so we wait until
+			// they reached the device before the gap starts
+			Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(100);
+			while (rx_bytes() < expected_rx_bytes + foreign_frame.size() && Clock::now() < deadline) {
+				std::this_thread::yield();
+			}
+			expected_rx_bytes += foreign_frame.size();
+			std::this_thread::sleep_for(std::chrono::nanoseconds(gap_ns));
+		}
+
+		std::vector<uint8_t> frame = make_frame(request.payload, device_address);
+		if (write(fd, frame.data(), frame.size()) != (ssize_t)frame.size()) {
+			++failures;
+			break;
+		}
+		expected_rx_bytes += frame.size();
+		++sent;
+
+		uint8_t response[TURAG_FELDBUS_DEVICE_ACTUAL_BUFFER_SIZE];
+		size_t length = frame_length(request.response_length);
+		for (unsigned i = 0; i < request.answers; ++i) {
+			if (!read_answer(fd, response, length) || !response_valid(response, length) ||
+					turag_feldbus_device_get_address(response) != (TURAG_FELDBUS_DEVICE_MASTER_ADDR | device_address)) {
+				fprintf(stderr, "stress: request %lu was not answered correctly\n", sent);
+				++failures;
+				// skip what is left of a broken answer
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				while (read_answer(fd, response, 1)) { }
+				expected_rx_bytes = rx_bytes();
+				break;
+			}
+		}
+		// the answer is passed on as soon as it is sent, but the bus is busy until it left the line
+		std::this_thread::sleep_for(std::chrono::nanoseconds(turag_feldbus_sim_bus_time_ns(length, baudrate) + gap_ns));
+	}
+
+	// the device must not have noticed any problem
+	uint32_t counters[4] = { 0 };
+	std::vector<uint8_t> frame = make_frame({0, TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_ALL}, device_address);
+	uint8_t response[TURAG_FELDBUS_DEVICE_ACTUAL_BUFFER_SIZE];
+	if (write(fd, frame.data(), frame.size()) == (ssize_t)frame.size() &&
+			read_answer(fd, response, frame_length(sizeof(counters))) &&
+			response_valid(response, frame_length(sizeof(counters)))) {
+		memcpy(counters, response + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH, sizeof(counters));
+	} else {
+		++failures;
+	}
+	if (counters[0] != sent + 1 || counters[1] || counters[2] || counters[3]) {
+		++failures;
+	}
+
+	stop = true;
+	main_loop.join();
+	turag_feldbus_sim_stats_t stats;
+	turag_feldbus_sim_get_stats(&stats);
+	turag_feldbus_sim_close();
+
+	printf("{\"stress\":{\"seconds\":%lu,\"requests\":%lu,\"failures\":%lu,"
+			"\"packages_correct\":%" PRIu32 ",\"packages_overflow\":%" PRIu32 ",\"packages_lost\":%" PRIu32 ",\"packages_chksum_mismatch\":%" PRIu32 ","
+			"\"interrupts\":%" PRIu32 ",\"rx_dropped\":%" PRIu32 "}}\n",
+			seconds, sent, failures, counters[0], counters[1], counters[2], counters[3],
+			stats.interrupts, stats.rx_dropped);
+	return failures ? 1 : 0;
+}
+
+} // namespace
+
+
+
+/*
+ * callbacks of the device stack
+ */
+extern "C" void turag_feldbus_stellantriebe_value_changed(uint8_t key) {
+	(void)key;
+}
+
+
+extern "C" uint32_t turag_feldbus_device_get_static_storage_capacity() {
+	return sizeof(storage);
+}
+
+extern "C" uint16_t turag_feldbus_device_get_static_storage_page_size() {
+	return 1;
+}
+
+extern "C" uint8_t turag_feldbus_device_read_from_static_storage(uint32_t offset, uint16_t size, uint8_t* buffer) {
+	memcpy(buffer, storage + offset, size);
+	return 0;
+}
+
+extern "C" uint8_t turag_feldbus_device_write_to_static_storage(uint32_t offset, const uint8_t* data, uint16_t size) {
+	memcpy(storage + offset, data, size);
+	++storage_writes;
+	return 0;
+}
+
+
+
+int main(int argc, char** argv) {
+	unsigned long iterations = 100000;
+	unsigned long baudrate = 115200;
+	std::string filter;
+	unsigned long stress_seconds = 0;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+			iterations = strtoul(argv[++i], nullptr, 0);
+		} else if (!strcmp(argv[i], "--baudrate") && i + 1 < argc) {
+			baudrate = strtoul(argv[++i], nullptr, 0);
+		} else if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+			filter = argv[++i];
+		} else if (!strcmp(argv[i], "--stress") && i + 1 < argc) {
+			stress_seconds = strtoul(argv[++i], nullptr, 0);
+		} else {
+			print_usage(argv[0]);
+			return 1;
+		}
+	}
+	if (iterations == 0) {
+		print_usage(argv[0]);
+		return 1;
+	}
+	if (stress_seconds) {
+		return run_stress(stress_seconds, baudrate);
+	}
+
+	printf("{\"config\":{\"crc_type\":%d,\"buffer_size\":%d,\"address_length\":%d,"
+			"\"rx_buffer_count\":%d,\"rx_checksum_in_isr\":%d,\"rx_address_filter\":%d,\"tx_checksum_in_isr\":%d,\"block_transfer\":%d,\"segmented_transfer\":%d,"
+			"\"baudrate\":%lu,\"iterations\":%lu,\"clock_overhead_ns\":%" PRIu64 "}}\n",
+			TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE, TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE, TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH,
+			TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT, TURAG_FELDBUS_DEVICE_CONFIG_RX_CHECKSUM_IN_ISR, TURAG_FELDBUS_DEVICE_CONFIG_RX_ADDRESS_FILTER,
+			TURAG_FELDBUS_DEVICE_CONFIG_TX_CHECKSUM_IN_ISR, TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER,
+			TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER, baudrate, iterations, measure_clock_overhead());
+
+	for (const Benchmark& benchmark : make_benchmarks()) {
+		if (!filter.empty() && std::string(benchmark.name).find(filter) == std::string::npos) {
+			continue;
+		}
+
+		init_device(benchmark.protocol);
+		for (const std::vector<uint8_t>& request : benchmark.setup) {
+			transfer(make_frame(request, device_address), nullptr);
+		}
+
+		FeldbusAddress_t address = benchmark.foreign ? foreign_address :
+				benchmark.broadcast ? TURAG_FELDBUS_DEVICE_BROADCAST_ADDR : device_address;
+		std::vector<uint8_t> frame = make_frame(benchmark.payload, address);
+
+		if (benchmark.check && !benchmark.check(frame, benchmark.idle)) {
+			fprintf(stderr, "%s: check failed\n", benchmark.name);
+			return 1;
+		}
+
+		// warm up caches and branch predictors
+		for (unsigned long i = 0; i < iterations / 10 + 1; ++i) {
+			transfer(frame, nullptr);
+			if (benchmark.idle) {
+				benchmark.idle();
+			}
+		}
+
+		Timing timing;
+		for (unsigned long i = 0; i < iterations; ++i) {
+			transfer(frame, &timing);
+			if (benchmark.idle) {
+				benchmark.idle();
+			}
+		}
+		if (benchmark.finish && !benchmark.finish(frame, benchmark.idle)) {
+			fprintf(stderr, "%s: finish failed\n", benchmark.name);
+			return 1;
+		}
+
+		double response_bytes = (double)timing.response_bytes / iterations;
+		double total_ns = (double)(timing.rx_isr_ns + timing.timeout_isr_ns + timing.processing_ns + timing.tx_isr_ns) / iterations;
+		uint64_t bus_ns = turag_feldbus_sim_bus_time_ns(frame.size() + (uint32_t)(response_bytes + 0.5), baudrate);
+
+		printf("{\"benchmark\":\"%s\",\"request_bytes\":%zu,\"response_bytes\":%.0f,"
+				"\"ns_per_packet\":%.1f,\"rx_isr_ns_per_byte\":%.1f,\"timeout_isr_ns\":%.1f,"
+				"\"processing_ns\":%.1f,\"tx_isr_ns_per_byte\":%.1f,\"response_bytes_per_s\":%.0f,\"bus_ns\":%" PRIu64 "}\n",
+				benchmark.name, frame.size(), response_bytes,
+				total_ns,
+				(double)timing.rx_isr_ns / iterations / frame.size(),
+				(double)timing.timeout_isr_ns / iterations,
+				(double)timing.processing_ns / iterations,
+				response_bytes > 0 ? (double)timing.tx_isr_ns / iterations / response_bytes : 0.0,
+				response_bytes * 1e9 / total_ns,
+				bus_ns);
+		fflush(stdout);
+	}
+
+	return 0;
+}
@@ -0,0 +1,85 @@
+/**
+ *  @file		feldbus_config.h
+ *  @ingroup    feldbus-slave-sim
+ *
+ * @brief Configuration used by the benchmark suite.
+ *
+ * All definitions can be overridden on the command line (e.g.
+ * -DTURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE=128) to compare
+ * different configurations.
+ */
+
+#ifndef FELDBUS_CONFIG_H_
+#define FELDBUS_CONFIG_H_
+
+
+#include <feldbus/protocol/base_protocol.h>
+
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE
+# define TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE					TURAG_FELDBUS_CHECKSUM_CRC8
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE
+# define TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE				80
+#endif
+
+// base.read_log only runs with -DTURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED=1
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED
+# define TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED				0
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY
+# define TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY			50
+#endif
+
+// optional reserved commands, enabled so that the benchmark covers them
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER
+# define TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER			1
+#endif
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH
+# define TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH	4
+#endif
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE
+# define TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE		1
+#endif
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS
+# define TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS			1
+#endif
+// end of the benchmark's storage, away from the blocks the benchmarks write
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS_OFFSET
+# define TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS_OFFSET	4092
+#endif
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH
+# define TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH				1
+#endif
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+# define TURAG_FELDBUS_DEVICE_CONFIG_PROFILING					1
+#endif
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+# define TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS					1
+#endif
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH
+# define TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH				32
+#endif
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE
+# define TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE		16
+#endif
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE
+# define TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE		256
+#endif
+
+#ifndef TURAG_FELDBUS_STELLANTRIEBE_STRUCTURED_OUTPUT_BUFFER_SIZE
+# define TURAG_FELDBUS_STELLANTRIEBE_STRUCTURED_OUTPUT_BUFFER_SIZE	32
+#endif
+
+// key-value store of feldbus_kvstore_bench.cpp
+#ifndef TURAG_FELDBUS_KVSTORE_KEY_COUNT
+# define TURAG_FELDBUS_KVSTORE_KEY_COUNT						8
+#endif
+#ifndef TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH
+# define TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH					16
+#endif
+
+
+#endif /* FELDBUS_CONFIG_H_ */
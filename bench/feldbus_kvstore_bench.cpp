@@ -0,0 +1,411 @@
+/**
+ *  @brief		Benchmark and consistency check for the key-value store
+ *  @file		feldbus_kvstore_bench.cpp
+ *  @ingroup	feldbus-slave-sim
+ *
+ * Runs the key-value store of feldbus_kvstore.c on the file backed static storage
+ * of feldbus_sim_storage.cpp and measures the time of turag_feldbus_kvstore_init(),
+ * turag_feldbus_kvstore_set() and turag_feldbus_kvstore_get(). Every step is checked
+ * against a copy of the values held in RAM:
+ * - kvstore.set: keys are set and erased N times, the values are compared after
+ *   every change. The store has to be compacted at least once.
+ * - kvstore.wear: writes per page of the storage after kvstore.set, reported by
+ *   turag_feldbus_sim_storage_page_writes(). No page may be written much more often
+ *   than the average, because the log spreads the writes over the whole area.
+ * - kvstore.init: the storage is closed and opened again, the values have to be
+ *   found again
+ * - kvstore.get: reads all values
+ * - kvstore.recovery: an update is interrupted after each byte of its record and
+ *   once with a damaged checksum by writing the storage file directly. After
+ *   turag_feldbus_kvstore_init() the previous value has to be present and the store
+ *   has to accept new values.
+ *
+ * Each step produces one line of JSON on stdout, the first line describes the
+ * configuration. The exit code is 1 if a check failed. The times include writing
+ * the file, which is synchronized after every write to the storage.
+ *
+ * Build (from the repository root):
+ *
+ *     gcc -O2 -c -Ibench -Isrc src/feldbus/device/feldbus_kvstore.c src/feldbus/util/crc_checksum.c
+ *     g++ -std=gnu++20 -O2 -Ibench -Isrc bench/feldbus_kvstore_bench.cpp src/feldbus/sim/feldbus_sim_storage.cpp *.o -o feldbus_kvstore_bench
+ *
+ * Without --capacity the storage holds at least 1 kB and grows with the page size,
+ * so that every key fits into one half of the store twice.
+ *
+ * Usage: feldbus_kvstore_bench [--iterations N] [--capacity BYTES] [--page-size BYTES] [--file PATH]
+ */
+
+#include <feldbus/device/feldbus_kvstore.h>
+#include <feldbus/sim/feldbus_sim.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// all keys are used, every key may hold a value of a different length
+constexpr uint8_t key_count = TURAG_FELDBUS_KVSTORE_KEY_COUNT;
+// header of each half: magic, generation and crc8
+constexpr unsigned header_size = 5;
+// record of the store: key, length, value and crc8
+constexpr unsigned record_overhead = 3;
+// allowed ratio between the writes of the most written page and the average
+constexpr unsigned max_wear_ratio = 4;
+
+// values the store should contain, an empty value means that the key is erased
+using Values = std::vector<std::vector<uint8_t>>;
+
+std::string path;
+// 0 selects a capacity that suits the page size
+uint32_t capacity = 0;
+uint16_t page_size = 1;
+
+
+uint64_t elapsed_ns(Clock::time_point start, Clock::time_point end) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+uint32_t pad(uint32_t size) {
+	return (size + page_size - 1) / page_size * page_size;
+}
+
+// Each half needs room for the header, the longest value of every key and the
+// END byte. Twice that leaves room for appending between compactions.
+uint32_t default_capacity() {
+	uint32_t half = pad(pad(header_size) + key_count * pad(record_overhead + TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH) + 1);
+	return std::max<uint32_t>(1024, 2 * 2 * half);
+}
+
+// opens the storage file like a device that is switched on
+bool open_store() {
+	if (turag_feldbus_sim_storage_open(path.c_str(), capacity, page_size) < 0) {
+		perror(path.c_str());
+		return false;
+	}
+	return turag_feldbus_kvstore_init(0, capacity);
+}
+
+bool format_store() {
+	turag_feldbus_sim_storage_close();
+	if (unlink(path.c_str()) < 0 && errno != ENOENT) {
+		perror(path.c_str());
+		return false;
+	}
+	return open_store();
+}
+
+std::vector<uint8_t> read_image() {
+	std::vector<uint8_t> image(capacity);
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0 || pread(fd, image.data(), image.size(), 0) != (ssize_t)image.size()) {
+		perror(path.c_str());
+		image.clear();
+	}
+	if (fd >= 0) {
+		close(fd);
+	}
+	return image;
+}
+
+// replaces the storage content while the device is switched off
+bool write_image(const std::vector<uint8_t>& image) {
+	turag_feldbus_sim_storage_close();
+	int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+	bool ok = fd >= 0 && pwrite(fd, image.data(), image.size(), 0) == (ssize_t)image.size();
+	if (!ok) {
+		perror(path.c_str());
+	}
+	if (fd >= 0) {
+		close(fd);
+	}
+	return ok;
+}
+
+std::vector<uint8_t> make_value(unsigned i) {
+	std::vector<uint8_t> value(1 + i % TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH);
+	for (size_t j = 0; j < value.size(); ++j) {
+		value[j] = (uint8_t)(i * 31 + j);
+	}
+	return value;
+}
+
+bool set_value(Values& values, uint8_t key, const std::vector<uint8_t>& value) {
+	if (!turag_feldbus_kvstore_set(key, value.data(), value.size())) {
+		fprintf(stderr, "setting key %u failed\n", key);
+		return false;
+	}
+	values[key] = value;
+	return true;
+}
+
+bool compare_values(const Values& values, const char* step) {
+	for (uint8_t key = 0; key < key_count; ++key) {
+		uint8_t buffer[TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH];
+		uint8_t length = turag_feldbus_kvstore_length(key);
+
+		if (length != values[key].size() ||
+				(length && (!turag_feldbus_kvstore_get(key, buffer, length) || memcmp(buffer, values[key].data(), length) != 0))) {
+			fprintf(stderr, "%s: key %u does not hold the expected value\n", step, key);
+			return false;
+		}
+	}
+	return true;
+}
+
+void print_result(const char* name, unsigned long operations, uint64_t ns, uint32_t page_writes) {
+	printf("{\"benchmark\":\"%s\",\"operations\":%lu,\"ns_per_operation\":%.1f,\"page_writes_per_operation\":%.2f}\n",
+			name, operations, (double)ns / operations, (double)page_writes / operations);
+}
+
+uint32_t total_page_writes() {
+	uint32_t writes = 0;
+	for (uint32_t page = 0; page < capacity / page_size; ++page) {
+		writes += turag_feldbus_sim_storage_page_writes(page);
+	}
+	return writes;
+}
+
+
+bool run_set(Values& values, unsigned long iterations) {
+	uint64_t ns = 0;
+
+	for (unsigned long i = 0; i < iterations; ++i) {
+		uint8_t key = i % key_count;
+		// every 13th change erases the key
+		std::vector<uint8_t> value = i % 13 == 5 ? std::vector<uint8_t>() : make_value(i);
+
+		Clock::time_point start = Clock::now();
+		bool ok = value.empty() ? turag_feldbus_kvstore_erase(key) : turag_feldbus_kvstore_set(key, value.data(), value.size());
+		ns += elapsed_ns(start, Clock::now());
+
+		if (!ok) {
+			fprintf(stderr, "kvstore.set: changing key %u failed\n", key);
+			return false;
+		}
+		values[key] = value;
+		if (!compare_values(values, "kvstore.set")) {
+			return false;
+		}
+	}
+
+	// both halves have to be in use, otherwise the store was never compacted
+	uint32_t half_pages = capacity / 2 / page_size;
+	uint32_t second_half_writes = 0;
+	for (uint32_t page = half_pages; page < 2 * half_pages; ++page) {
+		second_half_writes += turag_feldbus_sim_storage_page_writes(page);
+	}
+	if (second_half_writes == 0) {
+		fprintf(stderr, "kvstore.set: the store was not compacted, increase --iterations\n");
+		return false;
+	}
+
+	print_result("kvstore.set", iterations, ns, total_page_writes());
+	return true;
+}
+
+bool run_wear(unsigned long iterations) {
+	uint32_t pages = capacity / page_size;
+	uint32_t min_writes = UINT32_MAX;
+	uint32_t max_writes = 0;
+	uint32_t writes = 0;
+
+	for (uint32_t page = 0; page < pages; ++page) {
+		uint32_t page_writes = turag_feldbus_sim_storage_page_writes(page);
+		min_writes = std::min(min_writes, page_writes);
+		max_writes = std::max(max_writes, page_writes);
+		writes += page_writes;
+	}
+	printf("{\"benchmark\":\"kvstore.wear\",\"operations\":%lu,\"pages\":%" PRIu32 ",\"min_page_writes\":%" PRIu32
+			",\"max_page_writes\":%" PRIu32 ",\"mean_page_writes\":%.1f}\n",
+			iterations, pages, min_writes, max_writes, (double)writes / pages);
+
+	if ((uint64_t)max_writes * pages > (uint64_t)max_wear_ratio * writes) {
+		fprintf(stderr, "kvstore.wear: a page is written %" PRIu32 " times, more than %u times the average\n", max_writes, max_wear_ratio);
+		return false;
+	}
+	return true;
+}
+
+bool run_init(const Values& values, unsigned long iterations) {
+	uint64_t ns = 0;
+
+	for (unsigned long i = 0; i < iterations; ++i) {
+		turag_feldbus_sim_storage_close();
+		if (turag_feldbus_sim_storage_open(path.c_str(), capacity, page_size) < 0) {
+			perror(path.c_str());
+			return false;
+		}
+		Clock::time_point start = Clock::now();
+		bool ok = turag_feldbus_kvstore_init(0, capacity);
+		ns += elapsed_ns(start, Clock::now());
+
+		if (!ok) {
+			fprintf(stderr, "kvstore.init: the store could not be opened\n");
+			return false;
+		}
+		if (!compare_values(values, "kvstore.init")) {
+			return false;
+		}
+	}
+	print_result("kvstore.init", iterations, ns, 0);
+	return true;
+}
+
+bool run_get(const Values& values, unsigned long iterations) {
+	uint8_t buffer[TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH];
+	unsigned long operations = 0;
+	uint64_t ns = 0;
+
+	for (unsigned long i = 0; i < iterations; ++i) {
+		uint8_t key = i % key_count;
+		if (values[key].empty()) {
+			continue;
+		}
+		Clock::time_point start = Clock::now();
+		bool ok = turag_feldbus_kvstore_get(key, buffer, values[key].size());
+		ns += elapsed_ns(start, Clock::now());
+		++operations;
+
+		if (!ok || memcmp(buffer, values[key].data(), values[key].size()) != 0) {
+			fprintf(stderr, "kvstore.get: key %u does not hold the expected value\n", key);
+			return false;
+		}
+	}
+	if (operations) {
+		print_result("kvstore.get", operations, ns, 0);
+	}
+	return true;
+}
+
+bool run_recovery() {
+	Values values(key_count);
+	const uint8_t key = 1;
+	const std::vector<uint8_t> old_value = {0x12, 0x34};
+	const std::vector<uint8_t> new_value = {0x56, 0x78};
+
+	if (!format_store() || !set_value(values, 0, {0xab}) || !set_value(values, key, old_value)) {
+		fprintf(stderr, "kvstore.recovery: the store could not be prepared\n");
+		return false;
+	}
+
+	// the file before and after the update, the first changed byte starts the new record
+	std::vector<uint8_t> before = read_image();
+	if (before.empty() || !turag_feldbus_kvstore_set(key, new_value.data(), new_value.size())) {
+		return false;
+	}
+	std::vector<uint8_t> after = read_image();
+	if (after.empty()) {
+		return false;
+	}
+	size_t record = std::mismatch(before.begin(), before.end(), after.begin()).first - before.begin();
+	size_t record_size = record_overhead + new_value.size();
+	if (record + record_size > capacity) {
+		fprintf(stderr, "kvstore.recovery: the update did not change the storage\n");
+		return false;
+	}
+
+	// stop after each byte of the record and damage the checksum of the complete record
+	unsigned cases = 0;
+	for (size_t written = 0; written <= record_size; ++written) {
+		std::vector<uint8_t> image = after;
+		if (written < record_size) {
+			std::copy(before.begin() + record + written, before.begin() + record + record_size, image.begin() + record);
+		} else {
+			image[record + record_size - 1] ^= 0x5a;
+		}
+		if (!write_image(image) || !open_store()) {
+			fprintf(stderr, "kvstore.recovery: the store could not be opened after %zu bytes\n", written);
+			return false;
+		}
+		if (!compare_values(values, "kvstore.recovery")) {
+			return false;
+		}
+		++cases;
+	}
+
+	// the damaged record is overwritten by the next update, which has to survive a restart
+	if (!set_value(values, key, new_value) || !set_value(values, 0, {0xcd}) || !open_store() ||
+			!compare_values(values, "kvstore.recovery")) {
+		return false;
+	}
+	printf("{\"benchmark\":\"kvstore.recovery\",\"cases\":%u}\n", cases);
+	return true;
+}
+
+void print_usage(const char* name) {
+	fprintf(stderr, "usage: %s [--iterations N] [--capacity BYTES] [--page-size BYTES] [--file PATH]\n", name);
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+	unsigned long iterations = 10000;
+	bool temporary = true;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+			iterations = strtoul(argv[++i], nullptr, 0);
+		} else if (!strcmp(argv[i], "--capacity") && i + 1 < argc) {
+			capacity = strtoul(argv[++i], nullptr, 0);
+		} else if (!strcmp(argv[i], "--page-size") && i + 1 < argc) {
+			page_size = strtoul(argv[++i], nullptr, 0);
+		} else if (!strcmp(argv[i], "--file") && i + 1 < argc) {
+			path = argv[++i];
+			temporary = false;
+		} else {
+			print_usage(argv[0]);
+			return 1;
+		}
+	}
+	if (page_size && !capacity) {
+		capacity = default_capacity();
+	}
+	if (iterations == 0 || page_size == 0 || capacity % page_size != 0) {
+		print_usage(argv[0]);
+		return 1;
+	}
+	if (temporary) {
+		char name[] = "/tmp/feldbus_kvstore_bench.XXXXXX";
+		int fd = mkstemp(name);
+		if (fd < 0) {
+			perror("mkstemp");
+			return 1;
+		}
+		close(fd);
+		path = name;
+	}
+
+	printf("{\"config\":{\"capacity\":%" PRIu32 ",\"page_size\":%u,\"key_count\":%u,\"max_value_length\":%u,\"iterations\":%lu}}\n",
+			capacity, page_size, key_count, TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH, iterations);
+
+	Values values(key_count);
+	bool ok = format_store();
+	if (!ok) {
+		fprintf(stderr, "the store could not be formatted, the capacity may be too small\n");
+	}
+	ok = ok && run_set(values, iterations);
+	ok = ok && run_wear(iterations);
+	ok = ok && run_init(values, iterations / 100 + 1);
+	ok = ok && run_get(values, iterations);
+	ok = ok && run_recovery();
+
+	turag_feldbus_sim_storage_close();
+	if (temporary) {
+		unlink(path.c_str());
+	}
+	return ok ? 0 : 1;
+}
@@ -2,6 +2,7 @@
 #include <string.h>
 
 #include <feldbus/protocol/simple_io_protocol.h>
+#include <feldbus/device/feldbus_base.h>
 #include "feldbus_aseb.h"
 
 
@@ -293,9 +294,34 @@ FeldbusSize_t turag_feldbus_aseb_process_package(const uint8_t* message, Feldbus
 		if (analog_inputs && analog_inputs_size > 0) {
 			size += analog_inputs_size * 2;
 		}
-		response[0] = size + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH + 1;
+		size += TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH;
+		response[0] = size + turag_feldbus_device_checksum_length(size);
 		return 1;
 	}
 	return TURAG_FELDBUS_NO_ANSWER;
 }
 
+
+FeldbusSize_t turag_feldbus_aseb_frame_length(const uint8_t* message, FeldbusSize_t length) {
+	(void)length;
+	
+	switch (message[0]) {
+	case TURAG_FELDBUS_ASEB_SYNC:
+	case TURAG_FELDBUS_ASEB_SYNC_SIZE:
+	case TURAG_FELDBUS_ASEB_NUMBER_OF_DIGITAL_INPUTS:
+	case TURAG_FELDBUS_ASEB_NUMBER_OF_DIGITAL_OUTPUTS:
+	case TURAG_FELDBUS_ASEB_NUMBER_OF_ANALOG_INPUTS:
+	case TURAG_FELDBUS_ASEB_NUMBER_OF_PWM_OUTPUTS:
+	case TURAG_FELDBUS_ASEB_ANALOG_INPUT_RESOLUTION:
+		return 1;
+	case TURAG_FELDBUS_ASEB_ANALOG_INPUT_FACTOR:
+	case TURAG_FELDBUS_ASEB_PWM_OUTPUT_FREQUENCY:
+	case TURAG_FELDBUS_ASEB_PWM_OUTPUT_MAX_VALUE:
+	case TURAG_FELDBUS_ASEB_CHANNEL_NAME:
+	case TURAG_FELDBUS_ASEB_CHANNEL_NAME_LENGTH:
+		return 2;
+	default:
+		// outputs are read and written with the same command byte
+		return 0;
+	}
+}
@@ -46,6 +46,10 @@
 #include <feldbus/device/feldbus_config_check.h>
 
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 
 /**
  * \brief Typ zur Definition digitaler Ein-/Ausgänge.
@@ -111,4 +115,20 @@ void turag_feldbus_aseb_init(
 
 FeldbusSize_t turag_feldbus_aseb_process_package(const uint8_t* message, FeldbusSize_t message_length, uint8_t* response);
 
+/**
+ * Bestimmt die Länge von ASEB-Paketen anhand des Befehls.
+ *
+ * Kann mit turag_feldbus_device_set_frame_length_hint() gesetzt werden,
+ * damit Sync-Anfragen und Abfragen der Konfiguration ohne Warten auf den
+ * Timeout bearbeitet werden. Lese- und Schreibzugriffe auf Ausgänge
+ * unterscheiden sich nur in der Länge und werden daher weiterhin durch den
+ * Timeout abgeschlossen.
+ */
+FeldbusSize_t turag_feldbus_aseb_frame_length(const uint8_t* message, FeldbusSize_t length);
+
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* TINA_FELDBUS_SLAVE_FELDBUS_ASEB_H_ */
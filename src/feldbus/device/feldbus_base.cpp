@@ -12,23 +12,88 @@ static FeldbusSize_t process_request(const uint8_t* message, FeldbusSize_t lengt
 static FeldbusSize_t process_broadcast(const uint8_t* message, FeldbusSize_t length, uint8_t* response, bool* assert_bus_low);
 static bool check_assert_bus(const uint8_t* message, FeldbusSize_t length);
 static void turag_feldbus_device_start_transmission(FeldbusAddress_t origin);
+static void turag_feldbus_device_process_rxbuf(const uint8_t* rxbuf, FeldbusSize_t length);
+static inline void turag_feldbus_device_release_receiver(void);
+// optional hook of the device, its address is null if it is not implemented
+extern "C" void turag_feldbus_device_goto_sleep() __attribute__((weak));
+static void turag_feldbus_device_transmit_txbuf(void);
+#if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+static void turag_feldbus_device_trace_main(uint8_t event, const uint8_t* package, FeldbusSize_t length);
+static void turag_feldbus_device_trace_result(const uint8_t* rxbuf, FeldbusSize_t length, FeldbusSize_t response_length);
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED
+static FeldbusSize_t command_read_log(const uint8_t*, FeldbusSize_t, uint8_t* response);
+#endif
 static inline bool turag_feldbus_device_uuid_check(const uint8_t* compare);
+static inline void turag_feldbus_device_publish_address(FeldbusAddress_t address);
+static inline void turag_feldbus_device_set_address(FeldbusAddress_t address);
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE > 0
+static inline bool turag_feldbus_device_is_deferred_request(const uint8_t* message, FeldbusSize_t length);
+#endif
+#if TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW
+static void turag_feldbus_device_continue_segmented_read(void);
+#endif
+
+// work turag_feldbus_do_processing() does while no package is waiting
+#define TURAG_FELDBUS_DEVICE_BACKGROUND_WORK	(TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW || TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH > 0 || TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE || TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE > 0)
+#if TURAG_FELDBUS_DEVICE_BACKGROUND_WORK
+static inline bool turag_feldbus_device_background_work_pending(void);
+static void turag_feldbus_device_do_background_work(void);
+#endif
 
 turag_feldbus_device_t turag_feldbus_device = {
 	.transmitLength = 0,
 	.txOffset = 0,
+#if TURAG_FELDBUS_DEVICE_CONFIG_TX_CHECKSUM_IN_ISR
+	.txChecksumOffset = TURAG_FELDBUS_NO_ANSWER,
+	.tx_checksum = TURAG_FELDBUS_DEVICE_CHECKSUM_INIT,
+#endif
 	.rxOffset = 0,
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+	.rx_length = { 0 },
+	.rx_ready = { 0 },
+	.rx_write_slot = 0,
+	.rx_read_slot = 0,
+	.rx_discard = 0,
+	.rx_discard_address = 0,
+#else
 	.rx_length = 0,
+	.rx_ready = 0,
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_CHECKSUM_IN_ISR
+	.rx_checksum = TURAG_FELDBUS_DEVICE_CHECKSUM_INIT,
+# if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+	.rx_checksum16 = TURAG_CRC16_INIT,
+# endif
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_ADDRESS_FILTER
+	.rx_foreign = 0,
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_FRAME_LENGTH_HINTS
+	.rx_expected_length = 0,
+	.frame_length_hint = 0,
+#endif
 	.overflow = 0,
 	.package_lost_flag = 0,
 	.buffer_overflow_flag = 0,
-#if TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED
 	.transmission_active = 0,
-#endif	
+#if TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER
+	.rx_block_started = 0,
+#endif
 	.toggleLedBlocked = 0,
 	.packet_processor = 0,
 	.broadcast_processor = 0,
 	.my_address = 0,
+#if TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH == 2 && TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+	.rx_address = { 0 },
+	.rx_address_index = 0,
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS
+	.persisted_address = 0,
+#endif
+	.device_info = { 0 },
+	.extended_info = 0,
+	.extended_info_length = 0,
 	.name = 0,
 	.name_length = 0,
 	.versioninfo = 0,
@@ -39,14 +104,138 @@ turag_feldbus_device_t turag_feldbus_device = {
 	.packagecount_buffer_overflow = 0,
 	.packagecount_lost = 0,
 	.packagecount_chksum_mismatch = 0,
-	.uptime_counter = 0
+	.uptime_counter = 0,
+#if TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW
+	.segment_object = 0,
+	.segment_remaining = 0,
+	.segment_sequence = 0,
+	.segment_gap = 0,
+	.segment_offset = 0,
+	.segment_object_size = 0,
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH > 0
+	.bulk_queue = {},
+	.bulk_queue_head = 0,
+	.bulk_queue_count = 0,
+	.bulk_expected_sequence = 0,
+	.bulk_written_sequence = 0,
+	.bulk_error = 0,
+	.bulk_write_started = 0,
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE
+	.storage_write_state = TURAG_FELDBUS_DEVICE_STORAGE_WRITE_IDLE,
+	.storage_write_result = 0,
+	.storage_write_size = 0,
+	.storage_write_offset = 0,
+	.storage_write_data = { 0 },
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE > 0
+	.deferred_state = TURAG_FELDBUS_DEVICE_DEFERRED_IDLE,
+	.deferred_length = 0,
+	.deferred_request_length = 0,
+	.deferred_request_hash = 0,
+	.current_request = 0,
+	.current_request_length = 0,
+	.deferred_answer = { 0 },
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+	.profile = {},
+	.rx_timestamp = { 0 },
+	.tx_timestamp = 0,
+	.tx_duration = 0,
+	.tx_duration_ready = false,
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+	.rx_frame_length = 0,
+	.rx_frame_address = 0,
+	.rx_bytes_sequence = 0,
+	.rx_bytes = 0,
+	.foreign_bytes = 0,
+	.rx_bytes_reset = 0,
+	.foreign_bytes_reset = 0,
+	.tx_bytes = 0,
+	.broadcast_count = 0,
+	.other_reserved_count = 0,
+	.reserved_count = { 0 },
+	.protocol_count = { 0 },
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED
+	.debug_log = { 0 },
+	.debug_log_head = 0,
+	.debug_log_tail = 0,
+	.debug_log_dropped = 0,
+	.debug_log_dropped_read = 0,
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+	.trace_isr = {},
+	.trace_main = {},
+	.trace_main_isr_head = {},
+	.trace_dropped_read = 0,
+#endif
 };
 
 
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+// adds the duration of a stage to its statistics. Bucket n of the histogram
+// counts durations that need n significant bits after shifting them right by
+// TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKET_SHIFT, the last bucket takes all longer ones.
+static void turag_feldbus_device_profile_add(uint8_t stage, uint32_t cycles) {
+	turag_feldbus_device_profile_t* profile = &turag_feldbus_device.profile[stage];
 
-extern "C" void turag_feldbus_device_init(
+	if (cycles < profile->min) {
+		profile->min = cycles;
+	}
+	if (cycles > profile->max) {
+		profile->max = cycles;
+	}
+
+	uint8_t bucket = 0;
+	cycles >>= TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKET_SHIFT;
+	while (cycles && bucket < TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKETS - 1) {
+		cycles >>= 1;
+		++bucket;
+	}
+	if (profile->histogram[bucket] != 0xffff) {
+		++profile->histogram[bucket];
+	}
+}
+
+// takes over the duration of the last transmission from the transmit interrupt
+static void turag_feldbus_device_profile_transmission(void) {
+	if (__atomic_load_n(&turag_feldbus_device.tx_duration_ready, __ATOMIC_ACQUIRE)) {
+		turag_feldbus_device_profile_add(TURAG_FELDBUS_DEVICE_PROFILE_TRANSMIT, turag_feldbus_device.tx_duration);
+		__atomic_store_n(&turag_feldbus_device.tx_duration_ready, false, __ATOMIC_RELAXED);
+	}
+}
+
+static void turag_feldbus_device_reset_profile(void) {
+	// all stages are recorded by the main loop
+	for (turag_feldbus_device_profile_t& profile : turag_feldbus_device.profile) {
+		profile.min = UINT32_MAX;
+		profile.max = 0;
+		memset(profile.histogram, 0, sizeof(profile.histogram));
+	}
+}
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+// takes a consistent snapshot of the byte counters of the receive interrupt
+static void turag_feldbus_device_read_rx_bytes(uint32_t* rx_bytes, uint32_t* foreign_bytes) {
+	uint8_t sequence;
+	do {
+		sequence = __atomic_load_n(&turag_feldbus_device.rx_bytes_sequence, __ATOMIC_ACQUIRE);
+		*rx_bytes = turag_feldbus_device.rx_bytes;
+		*foreign_bytes = turag_feldbus_device.foreign_bytes;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		// retry if the interrupt updated the counters meanwhile
+	} while ((sequence & 1) || sequence != __atomic_load_n(&turag_feldbus_device.rx_bytes_sequence, __ATOMIC_RELAXED));
+}
+#endif
+
+
+
+static void turag_feldbus_device_setup(
 		FeldbusAddress_t bus_address, uint32_t uuid,
-		const char* name, const char* version_info,
 		uint8_t device_protocol, uint8_t device_type,
 		TuragFeldbusPacketProcessor packetProcessor,
 		TuragFeldbusBroadcastProcessor broadcastProcessor)
@@ -55,329 +244,1400 @@ extern "C" void turag_feldbus_device_init(
 
 	turag_feldbus_device.packet_processor = packetProcessor;
 	turag_feldbus_device.broadcast_processor = broadcastProcessor;
-	turag_feldbus_device.my_address = bus_address;
-	turag_feldbus_device.name = name;
-	turag_feldbus_device.name_length = std::strlen(name);
-	turag_feldbus_device.versioninfo = version_info;
-	turag_feldbus_device.version_info_length = std::strlen(version_info);
+#if TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS
+	// an address assigned by the master takes precedence, so the
+	// device does not need to be enumerated again after a reset
+	turag_feldbus_device.persisted_address = turag_feldbus_device_load_address();
+	if (turag_feldbus_device.persisted_address) {
+		bus_address = turag_feldbus_device.persisted_address;
+	}
+#endif
+	turag_feldbus_device_publish_address(bus_address);
 	turag_feldbus_device.device_protocol = device_protocol;
 	turag_feldbus_device.device_type = device_type;
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+	// the receive interrupt marks rx_write_slot as ready, which is not
+	// slot 0 anymore if the device is initialised again
+	turag_feldbus_device.rxbuf = turag_feldbus_device.rx_slots[turag_feldbus_device.rx_write_slot];
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+	turag_feldbus_device_reset_profile();
+#endif
 
+	// the device info never changes, so we build the response only once
+	BUFFER_CHECK(sizeof(turag_feldbus_device.device_info));
+	FeldbusSize_t extInfo_length = turag_feldbus_device.extended_info ?
+		turag_feldbus_device.extended_info_length :
+		std::min((size_t)TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE, turag_feldbus_device.name_length + turag_feldbus_device.version_info_length + 5);
+
+	uint8_t* device_info = turag_feldbus_device.device_info;
+	device_info[0] = turag_feldbus_device.device_protocol;
+	device_info[1] = turag_feldbus_device.device_type;
+	device_info[2] = TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE | 0x88;
+	device_info[3] = extInfo_length & 0xff;
+	device_info[4] = (extInfo_length >> 8) & 0xff;
+	device_info[5] = turag_feldbus_device.uuid[0];
+	device_info[6] = turag_feldbus_device.uuid[1];
+	device_info[7] = turag_feldbus_device.uuid[2];
+	device_info[8] = turag_feldbus_device.uuid[3];
+	device_info[9] = TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY & 0xff;
+	device_info[10] = TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY >> 8;
 
 	turag_feldbus_hardware_init();
 	
 	turag_feldbus_device_rts_off();
+#if TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER
+	turag_feldbus_device_continue_block_receive();
+#else
 	turag_feldbus_device_activate_rx_interrupt();
 	turag_feldbus_device_deactivate_dre_interrupt();
 	turag_feldbus_device_deactivate_tx_interrupt();
+#endif
+}
+
+
+extern "C" void turag_feldbus_device_init(
+		FeldbusAddress_t bus_address, uint32_t uuid,
+		const char* name, const char* version_info,
+		uint8_t device_protocol, uint8_t device_type,
+		TuragFeldbusPacketProcessor packetProcessor,
+		TuragFeldbusBroadcastProcessor broadcastProcessor)
+{
+	turag_feldbus_device.extended_info = 0;
+	turag_feldbus_device.extended_info_length = 0;
+	turag_feldbus_device.name = name;
+	turag_feldbus_device.name_length = std::strlen(name);
+	turag_feldbus_device.versioninfo = version_info;
+	turag_feldbus_device.version_info_length = std::strlen(version_info);
+
+	turag_feldbus_device_setup(bus_address, uuid, device_protocol, device_type, packetProcessor, broadcastProcessor);
+}
+
+
+extern "C" void turag_feldbus_device_init_descriptor(
+		FeldbusAddress_t bus_address, uint32_t uuid,
+		const turag_feldbus_device_descriptor_t* descriptor,
+		TuragFeldbusPacketProcessor packetProcessor,
+		TuragFeldbusBroadcastProcessor broadcastProcessor)
+{
+	// name and version info are part of the extended info
+	const uint8_t* extended_info = descriptor->extended_info;
+	turag_feldbus_device.extended_info = extended_info;
+	turag_feldbus_device.extended_info_length = descriptor->extended_info_length;
+	turag_feldbus_device.name = (const char*)extended_info + 5;
+	turag_feldbus_device.name_length = extended_info[1];
+	turag_feldbus_device.versioninfo = (const char*)extended_info + 5 + extended_info[1];
+	turag_feldbus_device.version_info_length = extended_info[2];
+
+	turag_feldbus_device_setup(bus_address, uuid, descriptor->device_protocol, descriptor->device_type, packetProcessor, broadcastProcessor);
+}
+
+
+// true if the next package can be processed
+static inline bool turag_feldbus_device_package_ready(void) {
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+	// We must not start processing while the answer to the previous
+	// package is still being transmitted, because it occupies txbuf.
+	return __atomic_load_n(&turag_feldbus_device.rx_ready[turag_feldbus_device.rx_read_slot], __ATOMIC_ACQUIRE) &&
+			!__atomic_load_n(&turag_feldbus_device.transmission_active, __ATOMIC_ACQUIRE);
+#else
+	return __atomic_load_n(&turag_feldbus_device.rx_ready, __ATOMIC_ACQUIRE);
+#endif
+}
+
+
+extern "C" void turag_feldbus_do_processing(void) {
+	// The receive interrupt publishes a package by setting rx_ready after
+	// everything else is written. Reading it with acquire semantics
+	// guarantees that we see the complete package, so the interrupts
+	// stay enabled while we take it over.
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+	turag_feldbus_device_profile_transmission();
+#endif
+	if (!turag_feldbus_device_package_ready()) {
+#if TURAG_FELDBUS_DEVICE_BACKGROUND_WORK
+		if (turag_feldbus_device_background_work_pending()) {
+			turag_feldbus_device_do_background_work();
+			return;
+		}
+#endif
+		// Without a sleep hook the next call sees a package that is
+		// completed right now, so no lock is needed.
+		if (turag_feldbus_device_goto_sleep) {
+#if TURAG_FELDBUS_DEVICE_CONFIG_LOCK_FREE_PROCESSING
+			// a package completed right now is only noticed after the next interrupt
+			turag_feldbus_device_goto_sleep();
+#else
+			// with disabled interrupts no package can be completed between
+			// the check and going to sleep
+			turag_feldbus_device_begin_interrupt_protect();
+			if (!turag_feldbus_device_package_ready()) {
+				turag_feldbus_device_goto_sleep();
+			}
+			turag_feldbus_device_end_interrupt_protect();
+#endif
+		}
+		return;
+	}
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+	// The receive interrupt stays enabled and fills the other slots
+	// while we are working on this one. The slot is released
+	// once the package is processed.
+	const uint8_t slot = turag_feldbus_device.rx_read_slot;
+	FeldbusSize_t length = turag_feldbus_device.rx_length[slot];
+	uint8_t* rxbuf = turag_feldbus_device.rx_slots[slot];
+# if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+	uint32_t rx_timestamp = turag_feldbus_device.rx_timestamp[slot];
+# endif
+#else
+	// we have to disable the receive interrupt to ensure that
+	// the rx-buffer does not get corrupted by incoming data
+	// (even though the protocol already enforces this and it should
+	// not happen at all). In block mode the reception is not
+	// started again before the package was processed.
+# if !TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER
+	turag_feldbus_device_deactivate_rx_interrupt();
+
+	// A byte received before the interrupt was disabled starts a new
+	// package and discards this one. No further byte can arrive now.
+	if (!__atomic_load_n(&turag_feldbus_device.rx_ready, __ATOMIC_ACQUIRE)) {
+		turag_feldbus_device_activate_rx_interrupt();
+		return;
+	}
+# endif
+
+	FeldbusSize_t length = turag_feldbus_device.rx_length;
+	__atomic_store_n(&turag_feldbus_device.rx_ready, false, __ATOMIC_RELAXED);
+	uint8_t* rxbuf = turag_feldbus_device.rxbuf;
+# if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+	uint32_t rx_timestamp = turag_feldbus_device.rx_timestamp[0];
+# endif
+#endif
+
+	// we release the blinking to indicate that the user program is
+	// still calling turag_feldbus_do_processing() as required.
+	__atomic_store_n(&turag_feldbus_device.toggleLedBlocked, false, __ATOMIC_RELAXED);
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+	// a long wait means the main loop calls turag_feldbus_do_processing() too rarely
+	turag_feldbus_device_profile_add(TURAG_FELDBUS_DEVICE_PROFILE_RX_WAIT, turag_feldbus_device_get_cycle_count() - rx_timestamp);
+#endif
+
+#if TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW
+	// a new request ends the segments of the previous one, the master
+	// resumes a segmented read by asking for it again
+	turag_feldbus_device.segment_remaining = 0;
+#endif
+
+	// if we are here, we have a package (with length > 1 that is addressed to us) safe in our buffer
+	// and we can start working on it
+	turag_feldbus_device_process_rxbuf(rxbuf, length);
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+	// release the slot
+	turag_feldbus_device.rx_read_slot = slot + 1 == TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT ? 0 : slot + 1;
+	__atomic_store_n(&turag_feldbus_device.rx_ready[slot], false, __ATOMIC_RELEASE);
+
+# if TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER
+	// The reception might have been stopped because all slots were occupied.
+	// Then no block is running and the interrupts cannot restart it, so
+	// we own rx_block_started and need no lock.
+	turag_feldbus_device_continue_block_receive();
+# endif
+#endif
+}
+
+
+static void turag_feldbus_device_process_rxbuf(const uint8_t* rxbuf, FeldbusSize_t length) {
+	// calculate checksum. This was already done by turag_feldbus_device_receive_timeout_occured()
+	// if TURAG_FELDBUS_DEVICE_CONFIG_RX_CHECKSUM_IN_ISR is set.
+#if !TURAG_FELDBUS_DEVICE_CONFIG_RX_CHECKSUM_IN_ISR
+# if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+	uint32_t checksum_start = turag_feldbus_device_get_cycle_count();
+# endif
+# if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_XOR
+	bool checksum_valid = xor_checksum_check(rxbuf, length - 1, rxbuf[length - 1]);
+# elif TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8
+	bool checksum_valid = turag_crc8_check(rxbuf, length - 1, rxbuf[length - 1]);
+# elif TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+	bool checksum_valid = length <= TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED_MAX_CRC8_LENGTH ?
+			turag_crc8_check(rxbuf, length - 1, rxbuf[length - 1]) :
+			turag_crc16_check(rxbuf, length - 2, (uint16_t)(rxbuf[length - 2] << 8) | rxbuf[length - 1]);
+# endif
+# if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+	turag_feldbus_device_profile_add(TURAG_FELDBUS_DEVICE_PROFILE_CHECKSUM, turag_feldbus_device_get_cycle_count() - checksum_start);
+# endif
+	if (!checksum_valid) {
+		++turag_feldbus_device.packagecount_chksum_mismatch;
+# if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+		turag_feldbus_device_trace_main(TURAG_FELDBUS_DEVICE_TRACE_CHECKSUM_ERROR, rxbuf, length);
+# endif
+		turag_feldbus_device_release_receiver();
+		return;
+	}
+#endif
+
+	++turag_feldbus_device.packagecount_correct;
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+	const FeldbusSize_t checksum_length = length <= TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED_MAX_CRC8_LENGTH ? 1 : 2;
+#else
+	const FeldbusSize_t checksum_length = 1;
+#endif
+
+	// The address is already checked in turag_feldbus_device_receive_timeout_occured().
+	// Thus the second check is only necessary
+	// to distinguish broadcasts from regular packages.
+	if (turag_feldbus_device_get_address(rxbuf) != TURAG_FELDBUS_DEVICE_BROADCAST_ADDR) {
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+		uint32_t processing_start = turag_feldbus_device_get_cycle_count();
+#endif
+		FeldbusSize_t response_length = process_request(
+			rxbuf + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH,
+			length - (checksum_length + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH),
+			turag_feldbus_device.txbuf + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH);
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+		turag_feldbus_device_profile_add(TURAG_FELDBUS_DEVICE_PROFILE_PROCESSING, turag_feldbus_device_get_cycle_count() - processing_start);
+#endif
+
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+		turag_feldbus_device_trace_result(rxbuf, length, response_length);
+#endif
+
+		// this happens if the device protocol or the user code returned TURAG_FELDBUS_NO_ANSWER.
+		if (response_length == TURAG_FELDBUS_NO_ANSWER) {
+			turag_feldbus_device_release_receiver();
+		} else {
+			turag_feldbus_device.transmitLength = response_length + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH;
+			turag_feldbus_device_start_transmission(turag_feldbus_device.my_address);
+		}
+	} else {
+		bool assert_bus_low = false;
+
+		// broadcasts
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+		uint32_t processing_start = turag_feldbus_device_get_cycle_count();
+#endif
+		FeldbusSize_t response_length = process_broadcast(
+			rxbuf + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH,
+			length - (checksum_length + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH),
+			turag_feldbus_device.txbuf + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH,
+			&assert_bus_low);
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+		turag_feldbus_device_profile_add(TURAG_FELDBUS_DEVICE_PROFILE_PROCESSING, turag_feldbus_device_get_cycle_count() - processing_start);
+#endif
+
+		if (assert_bus_low) {
+			turag_feldbus_device_assert_low();
+		}
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+		turag_feldbus_device_trace_result(rxbuf, length, response_length);
+#endif
+
+		// this happens if the device protocol or the user code returned TURAG_FELDBUS_NO_ANSWER.
+		if (response_length == TURAG_FELDBUS_NO_ANSWER) {
+			turag_feldbus_device_release_receiver();
+		} else {
+			turag_feldbus_device.transmitLength = response_length + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH;
+			turag_feldbus_device_start_transmission(TURAG_FELDBUS_DEVICE_BROADCAST_ADDR);
+		}
+	}
+}
+
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+// adds an event to the packet trace from the main loop
+static void turag_feldbus_device_trace_main(uint8_t event, const uint8_t* package, FeldbusSize_t length) {
+	// the entry follows everything the interrupts recorded so far
+	turag_feldbus_device.trace_main_isr_head[turag_feldbus_device.trace_main.head] =
+		__atomic_load_n(&turag_feldbus_device.trace_isr.head, __ATOMIC_ACQUIRE);
+	turag_feldbus_device_trace_write(&turag_feldbus_device.trace_main, event, package, length);
+}
+
+// records the answer to a package or the package itself if there is none
+static void turag_feldbus_device_trace_result(const uint8_t* rxbuf, FeldbusSize_t length, FeldbusSize_t response_length) {
+	if (response_length == TURAG_FELDBUS_NO_ANSWER) {
+		turag_feldbus_device_trace_main(TURAG_FELDBUS_DEVICE_TRACE_NO_ANSWER, rxbuf, length);
+	} else {
+		turag_feldbus_device_trace_main(TURAG_FELDBUS_DEVICE_TRACE_ANSWERED, turag_feldbus_device.txbuf + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH, response_length);
+	}
+}
+#endif
+
+
+static inline void turag_feldbus_device_release_receiver(void) {
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT == 1
+# if TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER
+	// The reception was not started again while processing the package.
+	// Only called if nothing is transmitted, so turag_feldbus_device_block_transmitted()
+	// cannot restart it at the same time and we need no lock.
+	turag_feldbus_device_continue_block_receive();
+# else
+	// the receive interrupt was disabled while processing the package
+	turag_feldbus_device_activate_rx_interrupt();
+# endif
+#endif
+}
+
+
+static void turag_feldbus_device_transmit_txbuf(void) {
+	turag_feldbus_device.txOffset = 0;
+#if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+	turag_feldbus_device.tx_bytes += turag_feldbus_device.transmitLength;
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+	turag_feldbus_device.tx_timestamp = turag_feldbus_device_get_cycle_count();
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER
+	turag_feldbus_device_rts_on();
+	turag_feldbus_device_transmit_block(turag_feldbus_device.txbuf, turag_feldbus_device.transmitLength);
+#else
+	turag_feldbus_device_deactivate_rx_interrupt();
+	turag_feldbus_device_rts_on();
+	turag_feldbus_device_activate_dre_interrupt();
+#endif
+}
+
+
+extern "C" uint32_t turag_feldbus_device_hash_uuid(const uint8_t* key, size_t length) {
+	uint32_t default_seed = 0x55555555;
+	uint32_t uuid = murmurhash3_x86_32(key, length, default_seed);
+
+	// prevent the unlikely case of getting 0, because we use this as an indicator for an old device
+	// not supporting UUIDs
+	if (uuid == 0) {
+		uuid = murmurhash3_x86_32(key, length, default_seed + 1);
+	}
+
+	return uuid;
+}
+
+
+static void turag_feldbus_device_start_transmission(FeldbusAddress_t origin) {
+	// set correct return address
+	turag_feldbus_device_put_address(turag_feldbus_device.txbuf, TURAG_FELDBUS_DEVICE_MASTER_ADDR | origin);
+
+	// calculate correct checksum and initiate transmission
+#if TURAG_FELDBUS_DEVICE_CONFIG_TX_CHECKSUM_IN_ISR
+	// turag_feldbus_device_ready_to_transmit() calculates the checksum on the fly
+	turag_feldbus_device.txChecksumOffset = turag_feldbus_device.transmitLength;
+# if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+	turag_feldbus_device.tx_checksum = turag_feldbus_device.transmitLength < TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED_MAX_CRC8_LENGTH ? TURAG_CRC8_INIT : TURAG_CRC16_INIT;
+# else
+	turag_feldbus_device.tx_checksum = TURAG_FELDBUS_DEVICE_CHECKSUM_INIT;
+# endif
+	turag_feldbus_device.transmitLength += turag_feldbus_device_checksum_length(turag_feldbus_device.transmitLength);
+#elif TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_XOR
+	turag_feldbus_device.txbuf[turag_feldbus_device.transmitLength] = xor_checksum_calculate(turag_feldbus_device.txbuf, turag_feldbus_device.transmitLength);
+	turag_feldbus_device.transmitLength += 1;
+#elif TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8
+	turag_feldbus_device.txbuf[turag_feldbus_device.transmitLength] = turag_crc8_calculate(turag_feldbus_device.txbuf, turag_feldbus_device.transmitLength);
+	turag_feldbus_device.transmitLength += 1;
+#elif TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+	if (turag_feldbus_device.transmitLength < TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED_MAX_CRC8_LENGTH) {
+		turag_feldbus_device.txbuf[turag_feldbus_device.transmitLength] = turag_crc8_calculate(turag_feldbus_device.txbuf, turag_feldbus_device.transmitLength);
+		turag_feldbus_device.transmitLength += 1;
+	} else {
+		// long packages are protected by CRC16 which is sent msb first
+		uint16_t crc = turag_crc16_calculate(turag_feldbus_device.txbuf, turag_feldbus_device.transmitLength);
+		turag_feldbus_device.txbuf[turag_feldbus_device.transmitLength] = crc >> 8;
+		turag_feldbus_device.txbuf[turag_feldbus_device.transmitLength + 1] = crc & 0xff;
+		turag_feldbus_device.transmitLength += 2;
+	}
+#endif
+
+	__atomic_store_n(&turag_feldbus_device.transmission_active, true, __ATOMIC_RELAXED);
+
+	turag_feldbus_device_transmit_txbuf();
+}
+
+
+static inline void turag_feldbus_device_publish_address(FeldbusAddress_t address) {
+	turag_feldbus_device.my_address = address;
+#if TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH == 2 && TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+	// the receive interrupt keeps running while we process a package and
+	// must not see a half-written 2-byte address, so it reads the copy
+	// that is not written right now
+	uint8_t index = turag_feldbus_device.rx_address_index ^ 1;
+	turag_feldbus_device.rx_address[index] = address;
+	__atomic_store_n(&turag_feldbus_device.rx_address_index, index, __ATOMIC_RELEASE);
+#endif
+}
+
+static inline void turag_feldbus_device_set_address(FeldbusAddress_t address) {
+	turag_feldbus_device_publish_address(address);
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS
+	// repeated broadcasts must not wear out the storage
+	if (address != turag_feldbus_device.persisted_address) {
+		turag_feldbus_device.persisted_address = address;
+		turag_feldbus_device_store_address(address);
+	}
+#endif
+}
+
+
+static inline bool turag_feldbus_device_uuid_check(const uint8_t* compare) {
+	return
+			turag_feldbus_device.uuid[0] == compare[0] &&
+			turag_feldbus_device.uuid[1] == compare[1] &&
+			turag_feldbus_device.uuid[2] == compare[2] &&
+			turag_feldbus_device.uuid[3] == compare[3];
+}
+
+
+/*
+ * Handlers of the reserved packets. They are called with the arguments
+ * following the command id.
+ */
+static FeldbusSize_t command_device_name(const uint8_t*, FeldbusSize_t, uint8_t* response) {
+	FeldbusSize_t name_length = std::min(turag_feldbus_device.name_length, (size_t)(TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH));
+	memcpy(response, turag_feldbus_device.name, name_length);
+	return name_length;
+}
+
+static FeldbusSize_t command_uptime_counter(const uint8_t*, FeldbusSize_t, uint8_t* response) {
+	BUFFER_CHECK(sizeof(turag_feldbus_device.uptime_counter));
+#if (TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY>0) && (TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY<=65535)
+	memcpy(response, &turag_feldbus_device.uptime_counter, sizeof(turag_feldbus_device.uptime_counter));
+#else
+	memset(response, 0, sizeof(turag_feldbus_device.uptime_counter));
+#endif
+	return sizeof(turag_feldbus_device.uptime_counter);
+}
+
+static FeldbusSize_t command_versioninfo(const uint8_t*, FeldbusSize_t, uint8_t* response) {
+	FeldbusSize_t version_length = std::min(turag_feldbus_device.version_info_length, (size_t)TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE);
+	memcpy(response, turag_feldbus_device.versioninfo, version_length);
+	return version_length;
+}
+
+static FeldbusSize_t command_package_count_correct(const uint8_t*, FeldbusSize_t, uint8_t* response) {
+	BUFFER_CHECK(sizeof(turag_feldbus_device.packagecount_correct));
+	memcpy(response, &turag_feldbus_device.packagecount_correct, sizeof(turag_feldbus_device.packagecount_correct));
+	return sizeof(turag_feldbus_device.packagecount_correct);
+}
+
+static FeldbusSize_t command_package_count_bufferoverflow(const uint8_t*, FeldbusSize_t, uint8_t* response) {
+	BUFFER_CHECK(sizeof(turag_feldbus_device.packagecount_buffer_overflow));
+	memcpy(response, &turag_feldbus_device.packagecount_buffer_overflow, sizeof(turag_feldbus_device.packagecount_buffer_overflow));
+	return sizeof(turag_feldbus_device.packagecount_buffer_overflow);
+}
+
+static FeldbusSize_t command_package_count_lost(const uint8_t*, FeldbusSize_t, uint8_t* response) {
+	BUFFER_CHECK(sizeof(turag_feldbus_device.packagecount_lost));
+	memcpy(response, &turag_feldbus_device.packagecount_lost, sizeof(turag_feldbus_device.packagecount_lost));
+	return sizeof(turag_feldbus_device.packagecount_lost);
+}
+
+static FeldbusSize_t command_package_count_chksum_mismatch(const uint8_t*, FeldbusSize_t, uint8_t* response) {
+	BUFFER_CHECK(sizeof(turag_feldbus_device.packagecount_chksum_mismatch));
+	memcpy(response, &turag_feldbus_device.packagecount_chksum_mismatch, sizeof(turag_feldbus_device.packagecount_chksum_mismatch));
+	return sizeof(turag_feldbus_device.packagecount_chksum_mismatch);
+}
+
+static FeldbusSize_t command_package_count_all(const uint8_t*, FeldbusSize_t, uint8_t* response) {
+	constexpr size_t size = sizeof(turag_feldbus_device.packagecount_correct) + sizeof(turag_feldbus_device.packagecount_buffer_overflow) + sizeof(turag_feldbus_device.packagecount_lost) + sizeof(turag_feldbus_device.packagecount_chksum_mismatch);
+	BUFFER_CHECK(size);
+	memcpy(response, &turag_feldbus_device.packagecount_correct, size);
+	return size;
+}
+
+static FeldbusSize_t command_reset_package_count(const uint8_t*, FeldbusSize_t, uint8_t*) {
+	turag_feldbus_device.packagecount_correct = 0;
+	turag_feldbus_device.packagecount_buffer_overflow = 0;
+	turag_feldbus_device.packagecount_lost = 0;
+	turag_feldbus_device.packagecount_chksum_mismatch = 0;
+#if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+	// the receive interrupt owns its counters, so we only remember their values
+	turag_feldbus_device_read_rx_bytes(&turag_feldbus_device.rx_bytes_reset, &turag_feldbus_device.foreign_bytes_reset);
+	turag_feldbus_device.tx_bytes = 0;
+	turag_feldbus_device.broadcast_count = 0;
+	turag_feldbus_device.other_reserved_count = 0;
+	memset(turag_feldbus_device.reserved_count, 0, sizeof(turag_feldbus_device.reserved_count));
+	memset(turag_feldbus_device.protocol_count, 0, sizeof(turag_feldbus_device.protocol_count));
+#endif
+	return 0;
+}
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+static FeldbusSize_t command_get_statistics(const uint8_t* data, FeldbusSize_t length, uint8_t* response) {
+	if (length == 0) {
+		BUFFER_CHECK(18);
+		uint32_t rx_bytes, foreign_bytes;
+		turag_feldbus_device_read_rx_bytes(&rx_bytes, &foreign_bytes);
+		rx_bytes -= turag_feldbus_device.rx_bytes_reset;
+		foreign_bytes -= turag_feldbus_device.foreign_bytes_reset;
+		memcpy(response, &rx_bytes, 4);
+		memcpy(response + 4, &turag_feldbus_device.tx_bytes, 4);
+		memcpy(response + 8, &foreign_bytes, 4);
+		memcpy(response + 12, &turag_feldbus_device.broadcast_count, 2);
+		memcpy(response + 14, &turag_feldbus_device.other_reserved_count, 2);
+		response[16] = TURAG_FELDBUS_DEVICE_STATISTICS_RESERVED_COUNT;
+		response[17] = TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS_COMMANDS;
+		return 18;
+	}
+	if (length != 2) {
+		return 0;
+	}
+
+	const uint16_t* counters;
+	uint8_t count;
+	switch (data[0]) {
+	case TURAG_FELDBUS_DEVICE_STATISTICS_RESERVED:
+		counters = turag_feldbus_device.reserved_count;
+		count = TURAG_FELDBUS_DEVICE_STATISTICS_RESERVED_COUNT;
+		break;
+	case TURAG_FELDBUS_DEVICE_STATISTICS_PROTOCOL:
+		counters = turag_feldbus_device.protocol_count;
+		count = TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS_COMMANDS;
+		break;
+	default:
+		// unknown group
+		return 0;
+	}
+
+	uint8_t first = data[1];
+	if (first >= count) {
+		return 0;
+	}
+	FeldbusSize_t size = std::min((FeldbusSize_t)((count - first) * sizeof(uint16_t)), (FeldbusSize_t)(TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE / sizeof(uint16_t) * sizeof(uint16_t)));
+	memcpy(response, counters + first, size);
+	return size;
+}
+
+// counts a request according to its command
+static inline void turag_feldbus_device_count_request(const uint8_t* message, FeldbusSize_t length) {
+	if (length == 0) {
+		// ping requests are not counted
+		return;
+	}
+	if (message[0] == 0) {
+		if (length > 1 && message[1] < TURAG_FELDBUS_DEVICE_STATISTICS_RESERVED_COUNT) {
+			++turag_feldbus_device.reserved_count[message[1]];
+		} else {
+			++turag_feldbus_device.other_reserved_count;
+		}
+	} else {
+		++turag_feldbus_device.protocol_count[message[0] < TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS_COMMANDS ? message[0] : 0];
+	}
+}
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+static FeldbusSize_t command_get_profile(const uint8_t* data, FeldbusSize_t length, uint8_t* response) {
+	if (length == 0) {
+		response[0] = TURAG_FELDBUS_DEVICE_PROFILE_STAGE_COUNT;
+		response[1] = TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKETS;
+		response[2] = TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKET_SHIFT;
+		return 3;
+	}
+	if (length != 1 || data[0] >= TURAG_FELDBUS_DEVICE_PROFILE_STAGE_COUNT) {
+		// unknown stage
+		return 0;
+	}
+
+	constexpr size_t size = 2 * sizeof(uint32_t) + TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKETS * sizeof(uint16_t);
+	BUFFER_CHECK(size);
+	const turag_feldbus_device_profile_t& profile = turag_feldbus_device.profile[data[0]];
+	memcpy(response, &profile.min, sizeof(profile.min));
+	memcpy(response + 4, &profile.max, sizeof(profile.max));
+	memcpy(response + 8, profile.histogram, sizeof(profile.histogram));
+	return size;
+}
+
+static FeldbusSize_t command_reset_profile(const uint8_t*, FeldbusSize_t, uint8_t*) {
+	turag_feldbus_device_reset_profile();
+	return 0;
+}
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+static FeldbusSize_t command_read_trace(const uint8_t*, FeldbusSize_t, uint8_t* response) {
+	constexpr size_t max_entries = (TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - 1) / sizeof(turag_feldbus_device_trace_t);
+	BUFFER_CHECK(1 + sizeof(turag_feldbus_device_trace_t));
+
+	turag_feldbus_device_trace_ring_t& isr_ring = turag_feldbus_device.trace_isr;
+	turag_feldbus_device_trace_ring_t& main_ring = turag_feldbus_device.trace_main;
+
+	// the interrupts keep adding entries to their ring meanwhile
+	uint8_t isr_head = __atomic_load_n(&isr_ring.head, __ATOMIC_ACQUIRE);
+	uint8_t dropped = __atomic_load_n(&isr_ring.dropped, __ATOMIC_ACQUIRE) + main_ring.dropped;
+	response[0] = dropped - turag_feldbus_device.trace_dropped_read;
+	turag_feldbus_device.trace_dropped_read = dropped;
+
+	uint8_t isr_tail = isr_ring.tail;
+	uint8_t main_tail = main_ring.tail;
+	size_t count = 0;
+	for (; count < max_entries; ++count) {
+		const turag_feldbus_device_trace_t* entry;
+		// an entry of the main loop comes after all entries the interrupts recorded before it
+		if (main_tail != main_ring.head && (isr_tail == turag_feldbus_device.trace_main_isr_head[main_tail] || isr_tail == isr_head)) {
+			entry = &main_ring.entries[main_tail];
+			main_tail = turag_feldbus_device_trace_next(main_tail);
+		} else if (isr_tail != isr_head) {
+			entry = &isr_ring.entries[isr_tail];
+			isr_tail = turag_feldbus_device_trace_next(isr_tail);
+		} else {
+			break;
+		}
+		memcpy(response + 1 + count * sizeof(turag_feldbus_device_trace_t), entry, sizeof(turag_feldbus_device_trace_t));
+	}
+	main_ring.tail = main_tail;
+	__atomic_store_n(&isr_ring.tail, isr_tail, __ATOMIC_RELEASE);
+
+	return 1 + count * sizeof(turag_feldbus_device_trace_t);
+}
+#endif
+
+static FeldbusSize_t command_get_uuid(const uint8_t*, FeldbusSize_t, uint8_t* response) {
+	BUFFER_CHECK(sizeof(turag_feldbus_device.uuid));
+	memcpy(response, turag_feldbus_device.uuid, sizeof(turag_feldbus_device.uuid));
+	return sizeof(turag_feldbus_device.uuid);
+}
+
+static FeldbusSize_t command_get_extended_info(const uint8_t*, FeldbusSize_t, uint8_t* response) {
+	BUFFER_CHECK(7);
+
+	if (turag_feldbus_device.extended_info) {
+		// built at compile time
+		memcpy(response, turag_feldbus_device.extended_info, turag_feldbus_device.extended_info_length);
+		return turag_feldbus_device.extended_info_length;
+	}
+
+	uint8_t name_length = std::min(turag_feldbus_device.name_length, (size_t)(TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - 6));
+	uint8_t version_info_length = std::min(turag_feldbus_device.version_info_length, (size_t)(TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - 5 - name_length));
+
+	response[0] = 0;
+	response[1] = name_length;
+	response[2] = version_info_length;
+	response[3] = TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE & 0xff;
+	response[4] = (TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE >> 8) & 0xff;
+	memcpy(response + 5, turag_feldbus_device.name, name_length);
+	memcpy(response + 5 + name_length, turag_feldbus_device.versioninfo, version_info_length);
+
+	return 5 + name_length + version_info_length;
+}
+
+static FeldbusSize_t command_get_static_storage_capacity(const uint8_t*, FeldbusSize_t, uint8_t* response) {
+	uint32_t storage_capacity = turag_feldbus_device_get_static_storage_capacity();
+	uint16_t page_size = turag_feldbus_device_get_static_storage_page_size();
+	memcpy(response, &storage_capacity, sizeof(storage_capacity));
+	memcpy(response + sizeof(storage_capacity), &page_size, sizeof(page_size));
+	return sizeof(storage_capacity) + sizeof(page_size);
+}
+
+// reads and writes have to wait until the pending writes are programmed,
+// otherwise they would see old data or overtake queued bulk frames
+static inline bool turag_feldbus_device_storage_busy(void) {
+	return
+#if TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH > 0
+		turag_feldbus_device.bulk_queue_count ||
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE
+		turag_feldbus_device.storage_write_state != TURAG_FELDBUS_DEVICE_STORAGE_WRITE_IDLE ||
+#endif
+		false;
+}
+
+static FeldbusSize_t command_read_from_static_storage(const uint8_t* data, FeldbusSize_t, uint8_t* response) {
+	uint32_t storage_capacity = turag_feldbus_device_get_static_storage_capacity();
+	uint32_t offset;
+	uint16_t size;
+	memcpy(&offset, data, sizeof(offset));
+	memcpy(&size, data + sizeof(offset), sizeof(size));
+
+	if (size + 1 > TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE) {
+		return TURAG_FELDBUS_NO_ANSWER;
+	} else if (offset + size > storage_capacity) {
+		response[0] = 1;
+	} else if (turag_feldbus_device_storage_busy()) {
+		response[0] = TURAG_FELDBUS_DEVICE_STORAGE_BUSY;
+	} else {
+		response[0] = turag_feldbus_device_read_from_static_storage(offset, size, response + 1);
+	}
+	return size + 1;
+}
+
+static FeldbusSize_t command_write_to_static_storage(const uint8_t* data, FeldbusSize_t length, uint8_t* response) {
+	uint32_t offset;
+	if (length <= sizeof(offset)) {
+		return TURAG_FELDBUS_NO_ANSWER;
+	}
+
+	uint32_t storage_capacity = turag_feldbus_device_get_static_storage_capacity();
+	uint16_t page_size = turag_feldbus_device_get_static_storage_page_size();
+	uint16_t size = length - sizeof(offset);
+	memcpy(&offset, data, sizeof(offset));
+
+	if (offset + size > storage_capacity || (page_size > 1 && offset % page_size != 0)) {
+		response[0] = 1;
+	} else if (turag_feldbus_device_storage_busy()) {
+		response[0] = TURAG_FELDBUS_DEVICE_STORAGE_BUSY;
+#if TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE
+	} else {
+		// the write is started by turag_feldbus_do_processing() after the answer
+		// is on its way
+		turag_feldbus_device.storage_write_offset = offset;
+		turag_feldbus_device.storage_write_size = size;
+		memcpy(turag_feldbus_device.storage_write_data, data + sizeof(offset), size);
+		turag_feldbus_device.storage_write_result = TURAG_FELDBUS_DEVICE_STORAGE_BUSY;
+		turag_feldbus_device.storage_write_state = TURAG_FELDBUS_DEVICE_STORAGE_WRITE_QUEUED;
+		response[0] = 0;
+	}
+#else
+	} else {
+		response[0] = turag_feldbus_device_write_to_static_storage(offset, data + sizeof(offset), size);
+	}
+#endif
+	return 1;
+}
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE
+static FeldbusSize_t command_static_storage_status(const uint8_t*, FeldbusSize_t, uint8_t* response) {
+	response[0] = turag_feldbus_device.storage_write_result;
+	return 1;
+}
+
+// starts the queued write or checks whether the running one is finished
+static void turag_feldbus_device_continue_storage_write(void) {
+	uint8_t result;
+	if (turag_feldbus_device.storage_write_state == TURAG_FELDBUS_DEVICE_STORAGE_WRITE_QUEUED) {
+		result = turag_feldbus_device_start_write_to_static_storage(
+			turag_feldbus_device.storage_write_offset,
+			turag_feldbus_device.storage_write_data,
+			turag_feldbus_device.storage_write_size);
+		if (result == 0) {
+			turag_feldbus_device.storage_write_state = TURAG_FELDBUS_DEVICE_STORAGE_WRITE_STARTED;
+			return;
+		}
+	} else {
+		result = turag_feldbus_device_poll_write_to_static_storage();
+		if (result == TURAG_FELDBUS_DEVICE_STORAGE_BUSY) {
+			return;
+		}
+	}
+	turag_feldbus_device.storage_write_result = result;
+	turag_feldbus_device.storage_write_state = TURAG_FELDBUS_DEVICE_STORAGE_WRITE_IDLE;
+}
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH
+static FeldbusSize_t command_hash_static_storage(const uint8_t* data, FeldbusSize_t, uint8_t* response) {
+	uint8_t algorithm = data[0];
+	uint32_t offset;
+	uint32_t length;
+	memcpy(&offset, data + 1, sizeof(offset));
+	memcpy(&length, data + 1 + sizeof(offset), sizeof(length));
+
+	if (algorithm != TURAG_FELDBUS_DEVICE_HASH_CRC16 && algorithm != TURAG_FELDBUS_DEVICE_HASH_MURMUR3) {
+		response[0] = TURAG_FELDBUS_DEVICE_HASH_UNKNOWN_ALGORITHM;
+		return 1;
+	}
+	if (offset + length > turag_feldbus_device_get_static_storage_capacity() || offset + length < offset) {
+		response[0] = 1;
+		return 1;
+	}
+	// the main loop does not answer other packages while hashing
+	if (length > TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH_MAX_LENGTH) {
+		response[0] = TURAG_FELDBUS_DEVICE_HASH_TOO_LONG;
+		return 1;
+	}
+	if (turag_feldbus_device_storage_busy()) {
+		response[0] = TURAG_FELDBUS_DEVICE_STORAGE_BUSY;
+		return 1;
+	}
+
+	// the response buffer holds the chunks until the hash is complete
+	uint16_t crc = TURAG_CRC16_INIT;
+	murmurhash3_x86_32_state murmur;
+	murmurhash3_x86_32_init(&murmur, 0);
+
+	while (length) {
+		uint16_t size = length < TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE ? length : TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE;
+		uint8_t error = turag_feldbus_device_read_from_static_storage(offset, size, response);
+		if (error) {
+			response[0] = error;
+			return 1;
+		}
+
+		if (algorithm == TURAG_FELDBUS_DEVICE_HASH_CRC16) {
+			for (uint16_t i = 0; i < size; ++i) {
+				crc = turag_crc16_update(crc, response[i]);
+			}
+		} else {
+			murmurhash3_x86_32_update(&murmur, response, size);
+		}
+		offset += size;
+		length -= size;
+	}
+
+	response[0] = 0;
+	if (algorithm == TURAG_FELDBUS_DEVICE_HASH_CRC16) {
+		response[1] = crc >> 8;
+		response[2] = crc & 0xff;
+		return 1 + sizeof(crc);
+	} else {
+		uint32_t hash = murmurhash3_x86_32_final(&murmur);
+		memcpy(response + 1, &hash, sizeof(hash));
+		return 1 + sizeof(hash);
+	}
+}
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER
+// payload of a segment following the sequence number
+# define SEGMENT_DATA_SIZE (TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - 1)
+
+// returns false if the object does not exist
+static bool object_size(uint8_t object, uint32_t* size) {
+	switch (object) {
+	case TURAG_FELDBUS_DEVICE_OBJECT_DEVICE_NAME:
+		*size = turag_feldbus_device.name_length;
+		return true;
+	case TURAG_FELDBUS_DEVICE_OBJECT_VERSIONINFO:
+		*size = turag_feldbus_device.version_info_length;
+		return true;
+	case TURAG_FELDBUS_DEVICE_OBJECT_STATIC_STORAGE:
+		*size = turag_feldbus_device_get_static_storage_capacity();
+		return true;
+	default:
+		if (object >= TURAG_FELDBUS_DEVICE_OBJECT_USER_FIRST) {
+			*size = turag_feldbus_device_get_object_size(object);
+			return *size != 0;
+		}
+		return false;
+	}
 }
 
+static uint8_t object_read(uint8_t object, uint32_t offset, uint16_t size, uint8_t* buffer) {
+	switch (object) {
+	case TURAG_FELDBUS_DEVICE_OBJECT_DEVICE_NAME:
+		memcpy(buffer, turag_feldbus_device.name + offset, size);
+		return 0;
+	case TURAG_FELDBUS_DEVICE_OBJECT_VERSIONINFO:
+		memcpy(buffer, turag_feldbus_device.versioninfo + offset, size);
+		return 0;
+	case TURAG_FELDBUS_DEVICE_OBJECT_STATIC_STORAGE:
+		if (turag_feldbus_device_storage_busy()) {
+			return TURAG_FELDBUS_DEVICE_STORAGE_BUSY;
+		}
+		return turag_feldbus_device_read_from_static_storage(offset, size, buffer);
+	default:
+		return turag_feldbus_device_read_object(object, offset, size, buffer);
+	}
+}
 
-extern "C" void turag_feldbus_do_processing(void) {
-	// One might think it is unnecessary to disable interrupts just for
-	// reading rx_length. But because rx_length is volatile the following
-	// scenario is quite possible: we copy the the value of rx_length from memory
-	// to our register. Then we receive a byte and turag_feldbus_device_byte_received() is called.
-	// This function is executed in interrupt context and clears rx_length. Then we continue here
-	// and evaluate the now invalid value of rx_length which was buffered
-	// in our register. For this reason we need to disable all interrupts before
-	// reading rx_length.
-	turag_feldbus_device_begin_interrupt_protect();
-
-	if (turag_feldbus_device.rx_length == 0) {
-		turag_feldbus_device_goto_sleep();
-		turag_feldbus_device_end_interrupt_protect();
-		return;
+// writes the segment at offset to response, a short segment ends the object
+static FeldbusSize_t fill_segment(uint8_t object, uint32_t size, uint32_t offset, uint8_t sequence, uint8_t* response) {
+	uint32_t left = offset < size ? size - offset : 0;
+	uint16_t segment_size = left < SEGMENT_DATA_SIZE ? left : SEGMENT_DATA_SIZE;
+	if (segment_size && object_read(object, offset, segment_size, response + 1) != 0) {
+		response[0] = TURAG_FELDBUS_DEVICE_SEGMENT_ERROR;
+		return 1;
 	}
+	response[0] = sequence;
+	return segment_size + 1;
+}
 
-	// we have to disable the receive interrupt to ensure that
-	// the rx-buffer does not get corrupted by incoming data
-	// (even though the protocol already enforces this and it should
-	// not happen at all)
-	turag_feldbus_device_deactivate_rx_interrupt();
+static FeldbusSize_t command_read_segmented(const uint8_t* data, FeldbusSize_t length, uint8_t* response) {
+	uint32_t size;
+	if ((length != 1 && length != 6 && length != 7) || !object_size(data[0], &size)) {
+		// unknown object
+		return 0;
+	}
 
-	// we copy the value of rx_length because it is volatile and accessing
-	// it is expensive.
-	FeldbusSize_t length = turag_feldbus_device.rx_length;
-	turag_feldbus_device.rx_length = 0;
+	if (length == 1) {
+		memcpy(response, &size, sizeof(size));
+		response[sizeof(size)] = TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW ? 0xff : 1;
+		return sizeof(size) + 1;
+	}
 
-	// we release the blinking to indicate that the user program is
-	// still calling turag_feldbus_do_processing() as required.
-	turag_feldbus_device.toggleLedBlocked = false;
-	turag_feldbus_device_end_interrupt_protect();
+	uint8_t object = data[0];
+	uint32_t offset;
+	memcpy(&offset, data + 1, sizeof(offset));
+	uint8_t sequence = data[5];
+	if (sequence == TURAG_FELDBUS_DEVICE_SEGMENT_ERROR) {
+		return TURAG_FELDBUS_NO_ANSWER;
+	}
 
-	// if we are here, we have a package (with length > 1 that is addressed to us) safe in our buffer
-	// and we can start working on it
+	FeldbusSize_t response_length = fill_segment(object, size, offset, sequence, response);
+
+#if TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW
+	// The following segments of the window are sent by turag_feldbus_do_processing(),
+	// each after the bus was idle for the receive timeout. The window ends with
+	// the object and before the sequence number reaches TURAG_FELDBUS_DEVICE_SEGMENT_ERROR.
+	uint8_t window = length == 7 ? data[6] : 1;
+	uint8_t last_sequence = TURAG_FELDBUS_DEVICE_SEGMENT_ERROR - 1 - sequence;
+	if (window > 1 && response_length == SEGMENT_DATA_SIZE + 1 && last_sequence) {
+		turag_feldbus_device.segment_object = object;
+		turag_feldbus_device.segment_object_size = size;
+		turag_feldbus_device.segment_offset = offset + SEGMENT_DATA_SIZE;
+		turag_feldbus_device.segment_sequence = sequence + 1;
+		__atomic_store_n(&turag_feldbus_device.segment_gap, false, __ATOMIC_RELAXED);
+		turag_feldbus_device.segment_remaining = window - 1 < last_sequence ? window - 1 : last_sequence;
+	}
+#endif
+	return response_length;
+}
 
+#if TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW
+// sends the next segment of the window once the previous one left txbuf
+static void turag_feldbus_device_continue_segmented_read(void) {
+	uint8_t* response = turag_feldbus_device.txbuf + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH;
+	FeldbusSize_t response_length = fill_segment(
+		turag_feldbus_device.segment_object, turag_feldbus_device.segment_object_size,
+		turag_feldbus_device.segment_offset, turag_feldbus_device.segment_sequence, response);
+
+	// the transmit interrupt only starts the gap timer if more segments follow
+	if (response_length == SEGMENT_DATA_SIZE + 1) {
+		turag_feldbus_device.segment_offset += SEGMENT_DATA_SIZE;
+		++turag_feldbus_device.segment_sequence;
+		--turag_feldbus_device.segment_remaining;
+	} else {
+		turag_feldbus_device.segment_remaining = 0;
+	}
+	__atomic_store_n(&turag_feldbus_device.segment_gap, false, __ATOMIC_RELAXED);
 
-	// calculate checksum
-#if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_XOR
-	if (!xor_checksum_check(turag_feldbus_device.rxbuf, length - 1, turag_feldbus_device.rxbuf[length - 1]))
-#elif TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8
-	if (!turag_crc8_check(turag_feldbus_device.rxbuf, length - 1, turag_feldbus_device.rxbuf[length - 1]))
+	turag_feldbus_device.transmitLength = response_length + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH;
+	turag_feldbus_device_start_transmission(turag_feldbus_device.my_address);
+}
 #endif
-	{
-		++turag_feldbus_device.packagecount_chksum_mismatch;
-		turag_feldbus_device_activate_rx_interrupt();
-		return;
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH > 0
+// drops the queued frames except the one being programmed, whose data
+// has to stay untouched until the storage is done with it
+static void bulk_write_clear(uint8_t error) {
+	if (!turag_feldbus_device.bulk_write_started) {
+		turag_feldbus_device.bulk_queue_head = 0;
+		turag_feldbus_device.bulk_queue_count = 0;
+	} else {
+		turag_feldbus_device.bulk_queue_count = 1;
 	}
+	turag_feldbus_device.bulk_error = error;
+}
 
-	++turag_feldbus_device.packagecount_correct;
+// starts programming the oldest queued frame or checks whether it is finished
+static void turag_feldbus_device_continue_bulk_write(void) {
+	const turag_feldbus_device_bulk_write_t* entry = &turag_feldbus_device.bulk_queue[turag_feldbus_device.bulk_queue_head];
+	uint8_t error;
 
-	// The address is already checked in turag_feldbus_device_receive_timeout_occured().
-	// Thus the second check is only necessary
-	// to distinguish broadcasts from regular packages.
-	if (*((FeldbusAddress_t*)turag_feldbus_device.rxbuf) != TURAG_FELDBUS_BROADCAST_ADDR) {
+	if (!turag_feldbus_device.bulk_write_started) {
+		error = turag_feldbus_device_start_write_to_static_storage(entry->offset, entry->data, entry->size);
+		if (error == 0) {
+			turag_feldbus_device.bulk_write_started = true;
+			return;
+		}
+	} else {
+		error = turag_feldbus_device_poll_write_to_static_storage();
+		if (error == TURAG_FELDBUS_DEVICE_STORAGE_BUSY) {
+			return;
+		}
+		turag_feldbus_device.bulk_write_started = false;
+	}
+	if (error) {
+		// the frames after this one would leave a gap in the storage
+		bulk_write_clear(error);
+		return;
+	}
 
-		turag_feldbus_device.transmitLength = process_request(
-			turag_feldbus_device.rxbuf + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH,
-			length - (1 + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH),
-			turag_feldbus_device.txbuf + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH) + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH;
+	++turag_feldbus_device.bulk_written_sequence;
+	--turag_feldbus_device.bulk_queue_count;
+	++turag_feldbus_device.bulk_queue_head;
+	if (turag_feldbus_device.bulk_queue_head == TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH) {
+		turag_feldbus_device.bulk_queue_head = 0;
+	}
+}
 
+static FeldbusSize_t command_bulk_write(const uint8_t* data, FeldbusSize_t length, uint8_t* response) {
+	uint32_t offset;
+	bool busy = false;
 
-		// this happens if the device protocol or the user code returned TURAG_FELDBUS_NO_ANSWER.
-		if (turag_feldbus_device.transmitLength == 0) {
-			turag_feldbus_device_activate_rx_interrupt();
+	if (length == 1) {
+		if (turag_feldbus_device.bulk_write_started) {
+			// the storage still reads the frame being programmed,
+			// the master repeats the restart once it is done
+			busy = true;
 		} else {
-			turag_feldbus_device_start_transmission(turag_feldbus_device.my_address);
+			bulk_write_clear(0);
+			turag_feldbus_device.bulk_expected_sequence = data[0];
+			turag_feldbus_device.bulk_written_sequence = data[0];
+		}
+	} else if (length > 1 + sizeof(offset)) {
+		// frames are never answered, the master asks for the state instead
+		if (data[0] != turag_feldbus_device.bulk_expected_sequence ||
+				turag_feldbus_device.bulk_error ||
+				turag_feldbus_device.bulk_queue_count == TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH) {
+			return TURAG_FELDBUS_NO_ANSWER;
 		}
-	} else {
-		bool assert_bus_low = false;
 
-		// broadcasts
-		turag_feldbus_device.transmitLength = process_broadcast(
-			turag_feldbus_device.rxbuf + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH,
-			length - (1 + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH),
-			turag_feldbus_device.txbuf + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH,
-			&assert_bus_low) + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH;
+		uint32_t storage_capacity = turag_feldbus_device_get_static_storage_capacity();
+		uint16_t page_size = turag_feldbus_device_get_static_storage_page_size();
+		uint16_t size = length - 1 - sizeof(offset);
+		memcpy(&offset, data + 1, sizeof(offset));
 
-		if (assert_bus_low) {
-			turag_feldbus_device_assert_low();
+		if (offset + size > storage_capacity || (page_size > 1 && offset % page_size != 0)) {
+			bulk_write_clear(1);
+			return TURAG_FELDBUS_NO_ANSWER;
 		}
 
-		// this happens if the device protocol or the user code returned TURAG_FELDBUS_NO_ANSWER.
-		if (turag_feldbus_device.transmitLength == 0) {
-			turag_feldbus_device_activate_rx_interrupt();
-		} else {
-			turag_feldbus_device_start_transmission(TURAG_FELDBUS_BROADCAST_ADDR);
+		unsigned index = turag_feldbus_device.bulk_queue_head + turag_feldbus_device.bulk_queue_count;
+		if (index >= TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH) {
+			index -= TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH;
 		}
+		turag_feldbus_device_bulk_write_t* entry = &turag_feldbus_device.bulk_queue[index];
+		entry->offset = offset;
+		entry->size = size;
+		memcpy(entry->data, data + 1 + sizeof(offset), size);
+
+		++turag_feldbus_device.bulk_queue_count;
+		++turag_feldbus_device.bulk_expected_sequence;
+		return TURAG_FELDBUS_NO_ANSWER;
+	} else if (length != 0) {
+		return TURAG_FELDBUS_NO_ANSWER;
 	}
-}
 
+	response[0] = turag_feldbus_device.bulk_expected_sequence;
+	response[1] = turag_feldbus_device.bulk_written_sequence;
+	response[2] = TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH - turag_feldbus_device.bulk_queue_count;
+	response[3] = busy ? TURAG_FELDBUS_DEVICE_STORAGE_BUSY : turag_feldbus_device.bulk_error;
+	return 4;
+}
+#endif
 
-extern "C" uint32_t turag_feldbus_device_hash_uuid(const uint8_t* key, size_t length) {
-	uint32_t default_seed = 0x55555555;
-	uint32_t uuid = murmurhash3_x86_32(key, length, default_seed);
+#if TURAG_FELDBUS_DEVICE_BACKGROUND_WORK
+static inline bool turag_feldbus_device_background_work_pending(void) {
+	return
+# if TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW
+		(turag_feldbus_device.segment_remaining && __atomic_load_n(&turag_feldbus_device.segment_gap, __ATOMIC_ACQUIRE)) ||
+# endif
+# if TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH > 0
+		turag_feldbus_device.bulk_queue_count ||
+# endif
+# if TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE
+		turag_feldbus_device.storage_write_state != TURAG_FELDBUS_DEVICE_STORAGE_WRITE_IDLE ||
+# endif
+# if TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE > 0
+		turag_feldbus_device_coroutine_ready() ||
+# endif
+		false;
+}
 
-	// prevent the unlikely case of getting 0, because we use this as an indicator for an old device
-	// not supporting UUIDs
-	if (uuid == 0) {
-		uuid = murmurhash3_x86_32(key, length, default_seed + 1);
+// does one step of the pending work, packages that arrived
+// in the meantime are processed in between
+static void turag_feldbus_device_do_background_work(void) {
+# if TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW
+	if (turag_feldbus_device.segment_remaining && __atomic_load_n(&turag_feldbus_device.segment_gap, __ATOMIC_ACQUIRE)) {
+		turag_feldbus_device_continue_segmented_read();
+		return;
 	}
-
-	return uuid;
+# endif
+# if TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE
+	// the storage handles one write at a time, queued bulk frames wait for it
+	if (turag_feldbus_device.storage_write_state != TURAG_FELDBUS_DEVICE_STORAGE_WRITE_IDLE) {
+		turag_feldbus_device_continue_storage_write();
+		return;
+	}
+# endif
+# if TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE > 0
+	if (turag_feldbus_device_coroutine_ready()) {
+		turag_feldbus_device_resume_coroutine();
+		return;
+	}
+# endif
+# if TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH > 0
+	if (turag_feldbus_device.bulk_queue_count) {
+		turag_feldbus_device_continue_bulk_write();
+	}
+# endif
 }
+#endif
 
 
-static void turag_feldbus_device_start_transmission(FeldbusAddress_t origin) {
-	// set correct return address
-	*(FeldbusAddress_t*)turag_feldbus_device.txbuf = TURAG_FELDBUS_MASTER_ADDR | origin;
+namespace {
 
-	// calculate correct checksum and initiate transmission
-#if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_XOR
-	turag_feldbus_device.txbuf[turag_feldbus_device.transmitLength] = xor_checksum_calculate(turag_feldbus_device.txbuf, turag_feldbus_device.transmitLength);
-	turag_feldbus_device.transmitLength += 1;
-#elif TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8
-	turag_feldbus_device.txbuf[turag_feldbus_device.transmitLength] = turag_crc8_calculate(turag_feldbus_device.txbuf, turag_feldbus_device.transmitLength);
-	turag_feldbus_device.transmitLength += 1;
-#endif
+// argument length of reserved packets whose handler checks the length itself
+constexpr uint8_t ANY_LENGTH = 0xff;
 
+struct ReservedCommand {
+	uint8_t command;
+	// number of arguments following the command id or ANY_LENGTH
+	uint8_t argument_length;
+	TuragFeldbusCommandHandler handler;
+};
 
+// Reserved packets of the base protocol. The dispatch table is generated
+// from this list at compile time, so the order does not matter.
+constexpr ReservedCommand reserved_commands[] = {
+	{ TURAG_FELDBUS_DEVICE_COMMAND_DEVICE_NAME,						0, command_device_name },
+	{ TURAG_FELDBUS_DEVICE_COMMAND_UPTIME_COUNTER,					0, command_uptime_counter },
+	{ TURAG_FELDBUS_DEVICE_COMMAND_VERSIONINFO,						0, command_versioninfo },
+	{ TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_CORRECT,			0, command_package_count_correct },
+	{ TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_BUFFEROVERFLOW,	0, command_package_count_bufferoverflow },
+	{ TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_LOST,				0, command_package_count_lost },
+	{ TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_CHKSUM_MISMATCH,	0, command_package_count_chksum_mismatch },
+	{ TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_ALL,				0, command_package_count_all },
+	{ TURAG_FELDBUS_DEVICE_COMMAND_RESET_PACKAGE_COUNT,				0, command_reset_package_count },
+	{ TURAG_FELDBUS_DEVICE_COMMAND_GET_UUID,						0, command_get_uuid },
+	{ TURAG_FELDBUS_DEVICE_COMMAND_GET_EXTENDED_INFO,				0, command_get_extended_info },
+	{ TURAG_FELDBUS_DEVICE_COMMAND_GET_STATIC_STORAGE_CAPACITY,		0, command_get_static_storage_capacity },
+	{ TURAG_FELDBUS_DEVICE_COMMAND_READ_FROM_STATIC_STORAGE,		6, command_read_from_static_storage },
+	{ TURAG_FELDBUS_DEVICE_COMMAND_WRITE_TO_STATIC_STORAGE,			ANY_LENGTH, command_write_to_static_storage },
+#if TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER
+	{ TURAG_FELDBUS_DEVICE_COMMAND_READ_SEGMENTED,					ANY_LENGTH, command_read_segmented },
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH > 0
+	{ TURAG_FELDBUS_DEVICE_COMMAND_BULK_WRITE,						ANY_LENGTH, command_bulk_write },
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE
+	{ TURAG_FELDBUS_DEVICE_COMMAND_STATIC_STORAGE_STATUS,			0, command_static_storage_status },
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH
+	{ TURAG_FELDBUS_DEVICE_COMMAND_HASH_STATIC_STORAGE,				9, command_hash_static_storage },
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+	{ TURAG_FELDBUS_DEVICE_COMMAND_GET_PROFILE,						ANY_LENGTH, command_get_profile },
+	{ TURAG_FELDBUS_DEVICE_COMMAND_RESET_PROFILE,					0, command_reset_profile },
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+	{ TURAG_FELDBUS_DEVICE_COMMAND_GET_STATISTICS,					ANY_LENGTH, command_get_statistics },
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+	{ TURAG_FELDBUS_DEVICE_COMMAND_READ_TRACE,						0, command_read_trace },
+#endif
 #if TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED
-		turag_feldbus_device.transmission_active = 1;
+	{ TURAG_FELDBUS_DEVICE_COMMAND_READ_LOG,						0, command_read_log },
 #endif
+};
 
-	turag_feldbus_device.txOffset = 0;
+// The helpers below consist of a single return statement, so the table
+// is also generated by C++11 compilers.
+constexpr size_t reserved_command_count = sizeof(reserved_commands) / sizeof(reserved_commands[0]);
 
-	turag_feldbus_device_deactivate_rx_interrupt();
-	turag_feldbus_device_rts_on();
-	turag_feldbus_device_activate_dre_interrupt();
+constexpr size_t reserved_command_table_size(size_t i = 0, size_t size = 0) {
+	return i == reserved_command_count ? size :
+			reserved_command_table_size(i + 1, reserved_commands[i].command + 1u > size ? reserved_commands[i].command + 1u : size);
 }
 
+// true if no entry behind entry j uses the command id of entry i
+constexpr bool reserved_command_unique(size_t i, size_t j) {
+	return j == reserved_command_count ||
+			(reserved_commands[i].command != reserved_commands[j].command && reserved_command_unique(i, j + 1));
+}
 
-static inline bool turag_feldbus_device_uuid_check(const uint8_t* compare) {
-	return
-			turag_feldbus_device.uuid[0] == compare[0] &&
-			turag_feldbus_device.uuid[1] == compare[1] &&
-			turag_feldbus_device.uuid[2] == compare[2] &&
-			turag_feldbus_device.uuid[3] == compare[3];
+constexpr bool reserved_commands_unique(size_t i = 0) {
+	return i == reserved_command_count || (reserved_command_unique(i, i + 1) && reserved_commands_unique(i + 1));
 }
 
+static_assert(reserved_commands_unique(), "reserved command defined twice");
+static_assert(reserved_command_table_size() <= TURAG_FELDBUS_DEVICE_COMMAND_USER_FIRST, "reserved command collides with user commands");
+#if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+static_assert(reserved_command_table_size() <= TURAG_FELDBUS_DEVICE_STATISTICS_RESERVED_COUNT, "reserved command without packet counter");
+#endif
 
-static FeldbusSize_t process_request(const uint8_t* message, FeldbusSize_t length, uint8_t* response) {
-	if (length == 0) {
-		// we received a ping request -> respond with empty packet
-		return 0;
-	} else if (message[0] == 0) {
-		// first data byte is zero -> reserved packet
-		if (length == 1) {
-			// received a device info request packet
-			BUFFER_CHECK(11);
-
-			FeldbusSize_t extInfo_length = std::min((size_t)TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE, turag_feldbus_device.name_length + turag_feldbus_device.version_info_length + 5);
-
-			response[0] = turag_feldbus_device.device_protocol;
-			response[1] = turag_feldbus_device.device_type;
-			response[2] = TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE | 0x88;
-			response[3] = extInfo_length & 0xff;
-			response[4] = (extInfo_length >> 8) & 0xff;
-			response[5] = turag_feldbus_device.uuid[0];
-			response[6] = turag_feldbus_device.uuid[1];
-			response[7] = turag_feldbus_device.uuid[2];
-			response[8] = turag_feldbus_device.uuid[3];
-			response[9] = TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY & 0xff;
-			response[10] = TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY >> 8;
-			return 11;
-		} else if (length == 2) {
-			switch (message[1]) {
-			case TURAG_FELDBUS_DEVICE_COMMAND_DEVICE_NAME: {
-				FeldbusSize_t name_length = std::min(turag_feldbus_device.name_length, (size_t)(TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH));
-				memcpy(response, turag_feldbus_device.name, name_length);
-				return name_length;
-			}
-			case TURAG_FELDBUS_DEVICE_COMMAND_UPTIME_COUNTER:
-#if (TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY>0) && (TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY<=65535)
-				BUFFER_CHECK(sizeof(turag_feldbus_device.uptime_counter));
-				memcpy(response, &turag_feldbus_device.uptime_counter, sizeof(turag_feldbus_device.uptime_counter));
-				return sizeof(turag_feldbus_device.uptime_counter);
-#else
-				static_assert(sizeof(uint32_t) + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH <= TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE, "Buffer overflow");
-				return = sizeof(uint32_t);
+struct ReservedCommandTable {
+	ReservedCommand entry[reserved_command_table_size()];
+};
+
+// entry with the given command id or an entry without handler
+constexpr ReservedCommand find_reserved_command(uint8_t command, size_t i = 0) {
+	return i == reserved_command_count ? ReservedCommand{ command, 0, nullptr } :
+			reserved_commands[i].command == command ? reserved_commands[i] : find_reserved_command(command, i + 1);
+}
+
+// command ids 0 .. N - 1 as template arguments (std::make_index_sequence needs C++14)
+template<size_t... Ids> struct CommandIds { };
+template<size_t N, size_t... Ids> struct MakeCommandIds : MakeCommandIds<N - 1, N - 1, Ids...> { };
+template<size_t... Ids> struct MakeCommandIds<0, Ids...> { typedef CommandIds<Ids...> type; };
+
+template<size_t... Ids>
+constexpr ReservedCommandTable make_reserved_command_table(CommandIds<Ids...>) {
+	return ReservedCommandTable{ { find_reserved_command(Ids)... } };
+}
+
+// indexed by command id, unused ids have no handler
+constexpr ReservedCommandTable reserved_command_table =
+		make_reserved_command_table(MakeCommandIds<reserved_command_table_size()>::type());
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_USER_COMMAND_COUNT > 0
+// handlers registered with turag_feldbus_device_register_command(),
+// indexed by command id - TURAG_FELDBUS_DEVICE_COMMAND_USER_FIRST
+TuragFeldbusCommandHandler user_commands[TURAG_FELDBUS_DEVICE_CONFIG_USER_COMMAND_COUNT];
 #endif
-				break;
 
-			case TURAG_FELDBUS_DEVICE_COMMAND_VERSIONINFO: {
-				FeldbusSize_t version_length = std::min(turag_feldbus_device.version_info_length, (size_t)TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE);
-				memcpy(response, turag_feldbus_device.versioninfo, version_length);
-				return version_length;
-			}
-			case TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_CORRECT:
-				BUFFER_CHECK(sizeof(turag_feldbus_device.packagecount_correct));
-				memcpy(response, &turag_feldbus_device.packagecount_correct, sizeof(turag_feldbus_device.packagecount_correct));
-				return sizeof(turag_feldbus_device.packagecount_correct);
-
-			case TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_BUFFEROVERFLOW:
-				BUFFER_CHECK(sizeof(turag_feldbus_device.packagecount_buffer_overflow));
-				memcpy(response, &turag_feldbus_device.packagecount_buffer_overflow, sizeof(turag_feldbus_device.packagecount_buffer_overflow));
-				return sizeof(turag_feldbus_device.packagecount_buffer_overflow);
-
-			case TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_LOST:
-				BUFFER_CHECK(sizeof(turag_feldbus_device.packagecount_lost));
-				memcpy(response, &turag_feldbus_device.packagecount_lost, sizeof(turag_feldbus_device.packagecount_lost));
-				return sizeof(turag_feldbus_device.packagecount_lost);
-
-			case TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_CHKSUM_MISMATCH:
-				BUFFER_CHECK(sizeof(turag_feldbus_device.packagecount_chksum_mismatch));
-				memcpy(response, &turag_feldbus_device.packagecount_chksum_mismatch, sizeof(turag_feldbus_device.packagecount_chksum_mismatch));
-				return sizeof(turag_feldbus_device.packagecount_chksum_mismatch);
-
-			case TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_ALL: {
-				constexpr size_t size = sizeof(turag_feldbus_device.packagecount_correct) + sizeof(turag_feldbus_device.packagecount_buffer_overflow) + sizeof(turag_feldbus_device.packagecount_lost) + sizeof(turag_feldbus_device.packagecount_chksum_mismatch);
-				BUFFER_CHECK(size);
-				memcpy(response, &turag_feldbus_device.packagecount_correct, size);
-				return size;
-			}
-			case TURAG_FELDBUS_DEVICE_COMMAND_RESET_PACKAGE_COUNT:
-				turag_feldbus_device.packagecount_correct = 0;
-				turag_feldbus_device.packagecount_buffer_overflow = 0;
-				turag_feldbus_device.packagecount_lost = 0;
-				turag_feldbus_device.packagecount_chksum_mismatch = 0;
-				return 0;
+} // namespace
 
-			case TURAG_FELDBUS_DEVICE_COMMAND_GET_UUID:
-				BUFFER_CHECK(sizeof(turag_feldbus_device.uuid));
-				memcpy(response, turag_feldbus_device.uuid, sizeof(turag_feldbus_device.uuid));
-				return sizeof(turag_feldbus_device.uuid);
 
-			case TURAG_FELDBUS_DEVICE_COMMAND_GET_EXTENDED_INFO: {
-				BUFFER_CHECK(7);
+extern "C" bool turag_feldbus_device_register_command(uint8_t command, TuragFeldbusCommandHandler handler) {
+#if TURAG_FELDBUS_DEVICE_CONFIG_USER_COMMAND_COUNT > 0
+	if (command >= TURAG_FELDBUS_DEVICE_COMMAND_USER_FIRST &&
+			command - TURAG_FELDBUS_DEVICE_COMMAND_USER_FIRST < TURAG_FELDBUS_DEVICE_CONFIG_USER_COMMAND_COUNT) {
+		user_commands[command - TURAG_FELDBUS_DEVICE_COMMAND_USER_FIRST] = handler;
+		return true;
+	}
+#else
+	(void)command;
+	(void)handler;
+#endif
+	return false;
+}
 
-				uint8_t name_length = std::min(turag_feldbus_device.name_length, (size_t)(TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - 6));
-				uint8_t version_info_length = std::min(turag_feldbus_device.version_info_length, (size_t)(TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - 5 - name_length));
+#if TURAG_FELDBUS_DEVICE_CONFIG_FRAME_LENGTH_HINTS
+extern "C" void turag_feldbus_device_set_frame_length_hint(TuragFeldbusFrameLengthHint hint) {
+	turag_feldbus_device.frame_length_hint = hint;
+}
 
-				response[0] = 0;
-				response[1] = name_length;
-				response[2] = version_info_length;
-				response[3] = TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE & 0xff;
-				response[4] = (TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE >> 8) & 0xff;
-				memcpy(response + 5, turag_feldbus_device.name, name_length);
-				memcpy(response + 5 + name_length, turag_feldbus_device.versioninfo, version_info_length);
+extern "C" FeldbusSize_t turag_feldbus_device_expected_frame_length(const uint8_t* package, FeldbusSize_t received) {
+	// broadcasts are left to the timeout
+	if (turag_feldbus_device_get_address(package) != turag_feldbus_device_rx_address()) {
+		return 0;
+	}
 
-				return 5 + name_length + version_info_length;
+	const uint8_t* message = package + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH;
+	FeldbusSize_t length = received - TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH;
+	FeldbusSize_t data_length = 0;
+
+	if (message[0] == 0) {
+		// Reserved packets are identified by the command id in the second byte.
+		// The device info request ends after the 0, but then the second
+		// byte is the checksum and we can only overestimate the length.
+		if (length == 2 && message[1] < reserved_command_table_size()) {
+			const ReservedCommand& entry = reserved_command_table.entry[message[1]];
+			if (entry.handler && entry.argument_length != ANY_LENGTH) {
+				data_length = 2 + entry.argument_length;
 			}
+		}
+	} else if (turag_feldbus_device.frame_length_hint) {
+		data_length = turag_feldbus_device.frame_length_hint(message, length);
+	}
 
-			case TURAG_FELDBUS_DEVICE_COMMAND_GET_STATIC_STORAGE_CAPACITY: {
-				uint32_t storage_capacity = turag_feldbus_device_get_static_storage_capacity();
-				uint16_t page_size = turag_feldbus_device_get_static_storage_page_size();
-				memcpy(response, &storage_capacity, sizeof(storage_capacity));
-				memcpy(response + sizeof(storage_capacity), &page_size, sizeof(page_size));
-				return sizeof(storage_capacity) + sizeof(page_size);
-			}
+	if (data_length == 0) {
+		return 0;
+	}
+	FeldbusSize_t total = TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH + data_length;
+	total += turag_feldbus_device_checksum_length(total);
+	// packages that turn out to be complete already are left to the timeout
+	return total > received ? total : 0;
+}
+#endif
 
-			default:
-				// unhandled reserved packet with length == 2
-				return TURAG_FELDBUS_NO_ANSWER;
-			}
+
+static FeldbusSize_t process_reserved_command(uint8_t command, const uint8_t* data, FeldbusSize_t length, uint8_t* response) {
+	if (command < reserved_command_table_size()) {
+		const ReservedCommand& entry = reserved_command_table.entry[command];
+		if (entry.handler && (entry.argument_length == ANY_LENGTH || entry.argument_length == length)) {
+			return entry.handler(data, length, response);
+		}
+	}
+#if TURAG_FELDBUS_DEVICE_CONFIG_USER_COMMAND_COUNT > 0
+	else if (command >= TURAG_FELDBUS_DEVICE_COMMAND_USER_FIRST &&
+			command - TURAG_FELDBUS_DEVICE_COMMAND_USER_FIRST < TURAG_FELDBUS_DEVICE_CONFIG_USER_COMMAND_COUNT) {
+		TuragFeldbusCommandHandler handler = user_commands[command - TURAG_FELDBUS_DEVICE_COMMAND_USER_FIRST];
+		if (handler) {
+			return handler(data, length, response);
+		}
+	}
+#endif
+	// unhandled reserved packet
+	return TURAG_FELDBUS_NO_ANSWER;
+}
+
+
+static FeldbusSize_t process_request(const uint8_t* message, FeldbusSize_t length, uint8_t* response) {
+#if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+	turag_feldbus_device_count_request(message, length);
+#endif
+
+	if (length == 0) {
+		// we received a ping request -> respond with empty packet
+		return 0;
+	} else if (message[0] == 0) {
+		// first data byte is zero -> reserved packet
+		if (length == 1) {
+			// received a device info request packet, the response was built by turag_feldbus_device_init()
+			memcpy(response, turag_feldbus_device.device_info, sizeof(turag_feldbus_device.device_info));
+			return sizeof(turag_feldbus_device.device_info);
 		} else {
-			// packets with length > 2
-			if (message[1] == TURAG_FELDBUS_DEVICE_COMMAND_READ_FROM_STATIC_STORAGE && length == 8) {
-				uint32_t storage_capacity = turag_feldbus_device_get_static_storage_capacity();
-				uint32_t offset;
-				uint16_t size;
-				memcpy(&offset, message + 2, sizeof(offset));
-				memcpy(&size, message + 2 + sizeof(offset), sizeof(size));
-
-				if (size + 1 > TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE) {
-					return TURAG_FELDBUS_NO_ANSWER;
-				} else if (offset + size > storage_capacity) {
-					response[0] = 1;
-				} else {
-					response[0] = turag_feldbus_device_read_from_static_storage(offset, size, response + 1);
-				}
-				return size + 1;
-			} else if (message[1] == TURAG_FELDBUS_DEVICE_COMMAND_WRITE_TO_STATIC_STORAGE && length > 6) {
-				uint32_t storage_capacity = turag_feldbus_device_get_static_storage_capacity();
-				uint16_t page_size = turag_feldbus_device_get_static_storage_page_size();
-				uint32_t offset;
-				uint32_t data_offset = 2 + sizeof(offset);
-				uint16_t size = length - data_offset;
-				memcpy(&offset, message + 2, sizeof(offset));
-
-				if (offset + size > storage_capacity || (page_size > 1 && offset % page_size != 0)) {
-					response[0] = 1;
-				} else {
-					response[0] = turag_feldbus_device_write_to_static_storage(offset, message + data_offset, size);
-				}
-				return 1;
-			} else {
-				// unhandled reserved packet with length > 2
-				return TURAG_FELDBUS_NO_ANSWER;
-			}
+			return process_reserved_command(message[1], message + 2, length - 2, response);
 		}
 	} else {
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE > 0
+		// repetitions of the deferred request are answered without the packet processor
+		uint8_t deferred_state = __atomic_load_n(&turag_feldbus_device.deferred_state, __ATOMIC_ACQUIRE);
+		if (deferred_state != TURAG_FELDBUS_DEVICE_DEFERRED_IDLE && turag_feldbus_device_is_deferred_request(message, length)) {
+			if (deferred_state == TURAG_FELDBUS_DEVICE_DEFERRED_PENDING) {
+				// the master polled too early, the empty package asks it to retry
+				return 0;
+			}
+			FeldbusSize_t response_length = turag_feldbus_device.deferred_length;
+			memcpy(response, turag_feldbus_device.deferred_answer, response_length);
+			__atomic_store_n(&turag_feldbus_device.deferred_state, TURAG_FELDBUS_DEVICE_DEFERRED_IDLE, __ATOMIC_RELAXED);
+			return response_length;
+		}
+#endif
 		// received some other packet --> let somebody else process it
 		if (turag_feldbus_device.packet_processor) {
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE > 0
+			turag_feldbus_device.current_request = message;
+			turag_feldbus_device.current_request_length = length;
+			FeldbusSize_t response_length = turag_feldbus_device.packet_processor(message, length, response);
+			turag_feldbus_device.current_request = 0;
+			return response_length == TURAG_FELDBUS_DEFERRED_ANSWER ? 0 : response_length;
+#else
 			return turag_feldbus_device.packet_processor(message, length, response);
+#endif
 		}
 	}
 	return TURAG_FELDBUS_NO_ANSWER;
 }
 
 
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE > 0
+static inline bool turag_feldbus_device_is_deferred_request(const uint8_t* message, FeldbusSize_t length) {
+	return length == turag_feldbus_device.deferred_request_length &&
+			murmurhash3_x86_32(message, length, 0) == turag_feldbus_device.deferred_request_hash;
+}
+
+extern "C" uint8_t* turag_feldbus_device_defer_answer(void) {
+	// An answer that is done but was never picked up makes way for the new
+	// request, the master has given up on it. Only the main loop leaves DONE.
+	if (!turag_feldbus_device.current_request ||
+			__atomic_load_n(&turag_feldbus_device.deferred_state, __ATOMIC_ACQUIRE) == TURAG_FELDBUS_DEVICE_DEFERRED_PENDING) {
+		return 0;
+	}
+	turag_feldbus_device.deferred_request_length = turag_feldbus_device.current_request_length;
+	turag_feldbus_device.deferred_request_hash = murmurhash3_x86_32(
+		turag_feldbus_device.current_request, turag_feldbus_device.current_request_length, 0);
+	__atomic_store_n(&turag_feldbus_device.deferred_state, TURAG_FELDBUS_DEVICE_DEFERRED_PENDING, __ATOMIC_RELAXED);
+	return turag_feldbus_device.deferred_answer;
+}
+
+extern "C" void turag_feldbus_device_complete_deferred_answer(FeldbusSize_t length) {
+	// a longer answer would send whatever follows the buffer
+	if (length == TURAG_FELDBUS_NO_ANSWER || length > TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE) {
+		__atomic_store_n(&turag_feldbus_device.deferred_state, TURAG_FELDBUS_DEVICE_DEFERRED_IDLE, __ATOMIC_RELEASE);
+		return;
+	}
+	turag_feldbus_device.deferred_length = length;
+	__atomic_store_n(&turag_feldbus_device.deferred_state, TURAG_FELDBUS_DEVICE_DEFERRED_DONE, __ATOMIC_RELEASE);
+}
+#endif
+
+
 static FeldbusSize_t process_broadcast(const uint8_t* message, FeldbusSize_t length, uint8_t* response, bool* assert_bus_low) {
 	// estimate for buffer requirements
 	BUFFER_CHECK(20);
 
+#if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+	++turag_feldbus_device.broadcast_count;
+#endif
+
 	if (length == 0) {
 		// compatibility mode to support deprecated Broadcasts without protocol-ID
 		if (turag_feldbus_device.broadcast_processor) {
@@ -409,23 +1669,23 @@ static FeldbusSize_t process_broadcast(const uint8_t* message, FeldbusSize_t len
 					switch (message[6]) {
 					case TURAG_FELDBUS_DEVICE_BROADCAST_UUID_ADDRESS:
 						// return Bus address
-						response[0] = turag_feldbus_device.my_address & 0xFF;
+						turag_feldbus_device_put_address(response, turag_feldbus_device.my_address);
 						return TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH;
 
 					case TURAG_FELDBUS_DEVICE_BROADCAST_UUID_RESET_ADDRESS:
 						// reset bus address
-						turag_feldbus_device.my_address = 0;
+						turag_feldbus_device_set_address(0);
 						return 0;
 					}
 					break;
 
-				case 7 + sizeof(FeldbusAddress_t):
+				case 7 + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH:
 					switch (message[6]) {
 					case TURAG_FELDBUS_DEVICE_BROADCAST_UUID_ADDRESS: {
 						// set Bus address
-						FeldbusAddress_t new_address = message[7];
-						if (new_address > 0 && new_address < TURAG_FELDBUS_MASTER_ADDR) {
-							turag_feldbus_device.my_address = new_address;
+						FeldbusAddress_t new_address = turag_feldbus_device_get_address(message + 7);
+						if (new_address > 0 && new_address < TURAG_FELDBUS_DEVICE_MASTER_ADDR) {
+							turag_feldbus_device_set_address(new_address);
 							response[0] = 1;
 						}
 						else {
@@ -447,7 +1707,7 @@ static FeldbusSize_t process_broadcast(const uint8_t* message, FeldbusSize_t len
 			return TURAG_FELDBUS_NO_ANSWER;
 
 		case TURAG_FELDBUS_DEVICE_BROADCAST_RESET_ADDRESSES:
-			turag_feldbus_device.my_address = 0;
+			turag_feldbus_device_set_address(0);
 			return TURAG_FELDBUS_NO_ANSWER;
 
 		case TURAG_FELDBUS_DEVICE_BROADCAST_REQUEST_BUS_ASSERTION:
@@ -518,8 +1778,6 @@ extern "C" void __attribute__((weak)) turag_feldbus_device_enable_bus_neighbours
 extern "C" void __attribute__((weak)) turag_feldbus_device_disable_bus_neighbours() {
 }
 
-extern "C" void __attribute__((weak)) turag_feldbus_device_goto_sleep() {
-}
 
 extern "C" void __attribute__((weak)) turag_feldbus_device_goto_deep_sleep() {
 }
@@ -540,190 +1798,174 @@ extern "C" uint8_t __attribute__((weak)) turag_feldbus_device_write_to_static_st
 	return 1;
 }
 
-
-
-#if TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED
-static uint8_t digit_to_hex(uint8_t dig) {
-	dig &= 0xF;
-	dig += '0';
-	if (dig > '9') dig += 'A' - '0' - 10;
-	return dig;
+extern "C" uint8_t __attribute__((weak)) turag_feldbus_device_start_write_to_static_storage(uint32_t offset, const uint8_t* data, uint16_t size) {
+	return turag_feldbus_device_write_to_static_storage(offset, data, size);
 }
 
-static void turag_feldbus_device_start_debug_transmission() {
-	turag_feldbus_device.transmission_active = 1;
+extern "C" uint8_t __attribute__((weak)) turag_feldbus_device_poll_write_to_static_storage(void) {
+	return 0;
+}
 
-	turag_feldbus_device.txOffset = 0;
+extern "C" uint32_t __attribute__((weak)) turag_feldbus_device_get_object_size(uint8_t object) {
+	return 0;
+}
 
-	turag_feldbus_device_deactivate_rx_interrupt();
-	turag_feldbus_device_rts_on();
-	turag_feldbus_device_activate_dre_interrupt();
+extern "C" uint8_t __attribute__((weak)) turag_feldbus_device_read_object(uint8_t object, uint32_t offset, uint16_t size, uint8_t* buffer) {
+	return 1;
 }
 
+#if TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS
+// the address is followed by its complement, which makes erased
+// or never written storage invalid
+extern "C" FeldbusAddress_t __attribute__((weak)) turag_feldbus_device_load_address(void) {
+	uint8_t data[2 * TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH];
+	if (turag_feldbus_device_read_from_static_storage(TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS_OFFSET, sizeof(data), data) != 0) {
+		return 0;
+	}
+	for (uint8_t i = 0; i < TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH; ++i) {
+		if ((uint8_t)~data[i] != data[TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH + i]) {
+			return 0;
+		}
+	}
+	FeldbusAddress_t address = turag_feldbus_device_get_address(data);
+	return address < TURAG_FELDBUS_DEVICE_MASTER_ADDR ? address : 0;
+}
 
+extern "C" void __attribute__((weak)) turag_feldbus_device_store_address(FeldbusAddress_t address) {
+	uint8_t data[2 * TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH];
+	turag_feldbus_device_put_address(data, address);
+	for (uint8_t i = 0; i < TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH; ++i) {
+		data[TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH + i] = ~data[i];
+	}
+	turag_feldbus_device_write_to_static_storage(TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS_OFFSET, data, sizeof(data));
+}
+#endif
 
-// public debug functions
-void print_text(const char *buf) {
-	while (turag_feldbus_device.transmission_active);
 
-	uint8_t i = 0;
 
-	while(*buf) {
-		turag_feldbus_device.txbuf[i] = *buf;
-		++i;
-		++buf;
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED
+// Debug records are only produced by the print functions and only consumed
+// by command_read_log(), each side owns one index. The indices are published
+// with release/acquire semantics, so the record data is complete before
+// the other side sees the new index.
+
+// longest text that fits into the log and into an answer to TURAG_FELDBUS_DEVICE_COMMAND_READ_LOG
+// (std::min is not constexpr before C++14)
+constexpr int debug_log_max_record = TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - 1 < 257 ? TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - 1 : 257;
+constexpr uint8_t debug_log_max_text = (TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_LOG_SIZE - 1 < debug_log_max_record ?
+		TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_LOG_SIZE - 1 : debug_log_max_record) - 2;
+
+static uint8_t debug_log_next(uint8_t index) {
+	return index + 1 == TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_LOG_SIZE ? 0 : index + 1;
+}
 
-		if (i >= TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE) {
-			i = 1;
-			break;
-		}
+// size of the record starting at index including its type
+static uint8_t debug_log_record_size(uint8_t index) {
+	switch (turag_feldbus_device.debug_log[index]) {
+	case TURAG_FELDBUS_DEVICE_LOG_TEXT:
+		return 2 + turag_feldbus_device.debug_log[debug_log_next(index)];
+	case TURAG_FELDBUS_DEVICE_LOG_CHAR:
+		return 2;
+	case TURAG_FELDBUS_DEVICE_LOG_LONG:
+	case TURAG_FELDBUS_DEVICE_LOG_SLONG:
+		return 5;
+	default:
+		return 3;
 	}
-	turag_feldbus_device.transmitLength = i;
-	turag_feldbus_device_start_debug_transmission();
 }
 
-void print_char(uint8_t x) {
-	while (turag_feldbus_device.transmission_active);
+// appends a record or drops it if it does not fit
+static void debug_log_write(uint8_t type, const void* value, uint8_t length) {
+	uint8_t head = turag_feldbus_device.debug_log_head;
+	uint8_t tail = __atomic_load_n(&turag_feldbus_device.debug_log_tail, __ATOMIC_ACQUIRE);
+	uint8_t used = head >= tail ? head - tail : head + TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_LOG_SIZE - tail;
+	uint8_t size = 1 + (type == TURAG_FELDBUS_DEVICE_LOG_TEXT) + length;
 
-	turag_feldbus_device.txbuf[0] = '0';
-	turag_feldbus_device.txbuf[1] = 'x';
-	turag_feldbus_device.txbuf[2] = digit_to_hex(x >> 4);
-	turag_feldbus_device.txbuf[3] = digit_to_hex(x);
+	// one byte stays free to distinguish a full log from an empty one
+	if (size > TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_LOG_SIZE - 1 - used) {
+		__atomic_store_n(&turag_feldbus_device.debug_log_dropped, turag_feldbus_device.debug_log_dropped + 1, __ATOMIC_RELEASE);
+		return;
+	}
 
-	turag_feldbus_device.transmitLength = 4;
-	turag_feldbus_device_start_debug_transmission();
+	turag_feldbus_device.debug_log[head] = type;
+	head = debug_log_next(head);
+	if (type == TURAG_FELDBUS_DEVICE_LOG_TEXT) {
+		turag_feldbus_device.debug_log[head] = length;
+		head = debug_log_next(head);
+	}
+	for (uint8_t i = 0; i < length; ++i) {
+		turag_feldbus_device.debug_log[head] = ((const uint8_t*)value)[i];
+		head = debug_log_next(head);
+	}
+	__atomic_store_n(&turag_feldbus_device.debug_log_head, head, __ATOMIC_RELEASE);
 }
 
-void print_short(uint16_t x) {
-	while (turag_feldbus_device.transmission_active);
+static FeldbusSize_t command_read_log(const uint8_t*, FeldbusSize_t, uint8_t* response) {
+	BUFFER_CHECK(1 + 5);
+	uint8_t tail = turag_feldbus_device.debug_log_tail;
+	uint8_t head = __atomic_load_n(&turag_feldbus_device.debug_log_head, __ATOMIC_ACQUIRE);
+	uint8_t dropped = __atomic_load_n(&turag_feldbus_device.debug_log_dropped, __ATOMIC_ACQUIRE);
 
-	turag_feldbus_device.txbuf[0] = '0';
-	turag_feldbus_device.txbuf[1] = 'x';
-	turag_feldbus_device.txbuf[2] = digit_to_hex(x >> 12);
-	turag_feldbus_device.txbuf[3] = digit_to_hex(x >> 8);
-	turag_feldbus_device.txbuf[4] = digit_to_hex(x >> 4);
-	turag_feldbus_device.txbuf[5] = digit_to_hex(x);
-	turag_feldbus_device.txbuf[6] = '\r';
-	turag_feldbus_device.txbuf[7] = '\n';
+	response[0] = dropped - turag_feldbus_device.debug_log_dropped_read;
+	turag_feldbus_device.debug_log_dropped_read = dropped;
 
-	turag_feldbus_device.transmitLength = 8;
-	turag_feldbus_device_start_debug_transmission();
+	FeldbusSize_t length = 1;
+	while (tail != head) {
+		uint8_t size = debug_log_record_size(tail);
+		if (length + size > TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE) {
+			break;
+		}
+		for (uint8_t i = 0; i < size; ++i) {
+			response[length] = turag_feldbus_device.debug_log[tail];
+			++length;
+			tail = debug_log_next(tail);
+		}
+	}
+	__atomic_store_n(&turag_feldbus_device.debug_log_tail, tail, __ATOMIC_RELEASE);
+	return length;
 }
-void print_short_nn(uint16_t x) {
-	while (turag_feldbus_device.transmission_active);
-
-	turag_feldbus_device.txbuf[0] = '0';
-	turag_feldbus_device.txbuf[1] = 'x';
-	turag_feldbus_device.txbuf[2] = digit_to_hex(x >> 12);
-	turag_feldbus_device.txbuf[3] = digit_to_hex(x >> 8);
-	turag_feldbus_device.txbuf[4] = digit_to_hex(x >> 4);
-	turag_feldbus_device.txbuf[5] = digit_to_hex(x);
 
-	turag_feldbus_device.transmitLength = 6;
-	turag_feldbus_device.transmission_active = 1;
-	turag_feldbus_device_start_debug_transmission();
-}
 
-void print_sshort(int16_t x) {
-	while (turag_feldbus_device.transmission_active);
 
-	if (x<0) {
-		turag_feldbus_device.txbuf[0] = '-';
-		x=-x;
-	} else turag_feldbus_device.txbuf[0] = '+';
+// public debug functions
+void print_text(const char *buf) {
+	uint8_t length = 0;
+	while (buf[length] && length < debug_log_max_text) {
+		++length;
+	}
+	debug_log_write(TURAG_FELDBUS_DEVICE_LOG_TEXT, buf, length);
+}
 
-	turag_feldbus_device.txbuf[1] = '0';
-	turag_feldbus_device.txbuf[2] = 'x';
-	turag_feldbus_device.txbuf[3] = digit_to_hex(x >> 12);
-	turag_feldbus_device.txbuf[4] = digit_to_hex(x >> 8);
-	turag_feldbus_device.txbuf[5] = digit_to_hex(x >> 4);
-	turag_feldbus_device.txbuf[6] = digit_to_hex(x);
-	turag_feldbus_device.txbuf[7] = '\r';
-	turag_feldbus_device.txbuf[8] = '\n';
+void print_char(uint8_t x) {
+	debug_log_write(TURAG_FELDBUS_DEVICE_LOG_CHAR, &x, sizeof(x));
+}
 
-	turag_feldbus_device.transmitLength = 9;
-	turag_feldbus_device_start_debug_transmission();
+void print_short(uint16_t x) {
+	debug_log_write(TURAG_FELDBUS_DEVICE_LOG_SHORT, &x, sizeof(x));
 }
-void print_sshort_nn(int16_t x) {
-	while (turag_feldbus_device.transmission_active);
 
-	if (x<0) {
-		turag_feldbus_device.txbuf[0] = '-';
-		x=-x;
-	} else turag_feldbus_device.txbuf[0] = '+';
+void print_short_nn(uint16_t x) {
+	debug_log_write(TURAG_FELDBUS_DEVICE_LOG_SHORT_NN, &x, sizeof(x));
+}
 
-	turag_feldbus_device.txbuf[1] = '0';
-	turag_feldbus_device.txbuf[2] = 'x';
-	turag_feldbus_device.txbuf[3] = digit_to_hex(x >> 12);
-	turag_feldbus_device.txbuf[4] = digit_to_hex(x >> 8);
-	turag_feldbus_device.txbuf[5] = digit_to_hex(x >> 4);
-	turag_feldbus_device.txbuf[6] = digit_to_hex(x);
+void print_sshort(int16_t x) {
+	debug_log_write(TURAG_FELDBUS_DEVICE_LOG_SSHORT, &x, sizeof(x));
+}
 
-	turag_feldbus_device.transmitLength = 7;
-	turag_feldbus_device_start_debug_transmission();
+void print_sshort_nn(int16_t x) {
+	debug_log_write(TURAG_FELDBUS_DEVICE_LOG_SSHORT_NN, &x, sizeof(x));
 }
 
 void print_long(uint32_t x) {
-	while (turag_feldbus_device.transmission_active);
-
-	turag_feldbus_device.txbuf[0] = '0';
-	turag_feldbus_device.txbuf[1] = 'x';
-	turag_feldbus_device.txbuf[2] = digit_to_hex(x >> 28);
-	turag_feldbus_device.txbuf[3] = digit_to_hex(x >> 24);
-	turag_feldbus_device.txbuf[4] = digit_to_hex(x >> 20);
-	turag_feldbus_device.txbuf[5] = digit_to_hex(x >> 16);
-	turag_feldbus_device.txbuf[6] = digit_to_hex(x >> 12);
-	turag_feldbus_device.txbuf[7] = digit_to_hex(x >> 8);
-	turag_feldbus_device.txbuf[8] = digit_to_hex(x >> 4);
-	turag_feldbus_device.txbuf[9] = digit_to_hex(x);
-	turag_feldbus_device.txbuf[10] = '\r';
-	turag_feldbus_device.txbuf[11] = '\n';
-
-
-	turag_feldbus_device.transmitLength = 12;
-	turag_feldbus_device_start_debug_transmission();
+	debug_log_write(TURAG_FELDBUS_DEVICE_LOG_LONG, &x, sizeof(x));
 }
 
 void print_short_d(int16_t x) {
-	while (turag_feldbus_device.transmission_active);
-
-	turag_feldbus_device.txbuf[0] = ' ';
-	turag_feldbus_device.txbuf[1] = ' ';
-	turag_feldbus_device.txbuf[2] = ' ';
-	turag_feldbus_device.txbuf[3] = ' ';
-	turag_feldbus_device.txbuf[4] = ' ';
-	turag_feldbus_device.txbuf[5] = ' ';
-	turag_feldbus_device.txbuf[6] = '\r';
-	turag_feldbus_device.txbuf[7] = '\n';
-	itoa(x, (char*)turag_feldbus_device.txbuf, 10);
-
-	turag_feldbus_device.transmitLength = 8;
-	turag_feldbus_device_start_debug_transmission();
+	debug_log_write(TURAG_FELDBUS_DEVICE_LOG_SHORT_D, &x, sizeof(x));
 }
 
 void print_slong(int32_t x) {
-	while (turag_feldbus_device.transmission_active);
-
-	if (x<0) {
-		turag_feldbus_device.txbuf[0] = '-';
-		x=-x;
-	} else turag_feldbus_device.txbuf[0] = '+';
-
-	turag_feldbus_device.txbuf[1] = '0';
-	turag_feldbus_device.txbuf[2] = 'x';
-	turag_feldbus_device.txbuf[3] = digit_to_hex(x >> 28);
-	turag_feldbus_device.txbuf[4] = digit_to_hex(x >> 24);
-	turag_feldbus_device.txbuf[5] = digit_to_hex(x >> 20);
-	turag_feldbus_device.txbuf[6] = digit_to_hex(x >> 16);
-	turag_feldbus_device.txbuf[7] = digit_to_hex(x >> 12);
-	turag_feldbus_device.txbuf[8] = digit_to_hex(x >> 8);
-	turag_feldbus_device.txbuf[9] = digit_to_hex(x >> 4);
-	turag_feldbus_device.txbuf[10] = digit_to_hex(x);
-	turag_feldbus_device.txbuf[11] = '\r';
-	turag_feldbus_device.txbuf[12] = '\n';
-
-	turag_feldbus_device.transmitLength = 13;
-	turag_feldbus_device_start_debug_transmission();
+	debug_log_write(TURAG_FELDBUS_DEVICE_LOG_SLONG, &x, sizeof(x));
 }
 #endif
 
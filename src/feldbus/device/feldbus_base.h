@@ -321,6 +321,9 @@ extern void turag_feldbus_device_deactivate_tx_interrupt(void);
  * 
  * After being enabled it should trigger the call of turag_feldbus_device_receive_timeout_occured only once
  * and deactivate itself afterwards.
+ *
+ * With \ref TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER the function is also called from
+ * turag_feldbus_device_transmission_complete() to keep the bus idle between the segments of a window.
  */
 extern void turag_feldbus_device_start_receive_timeout(void);
 
@@ -374,12 +377,57 @@ extern void turag_feldbus_device_disable_bus_neighbours();
  */
 extern void turag_feldbus_device_assert_low();
 
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING || defined(__DOXYGEN__)
+/**
+ * Returns the value of a free-running counter, e.g. the cycle counter of
+ * the CPU or a hardware timer. Only differences of two values are used, so the
+ * counter may overflow. Called from interrupt context and from turag_feldbus_do_processing().
+ *
+ * \pre Nur benötigt, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_PROFILING auf 1 definiert ist.
+ */
+extern uint32_t turag_feldbus_device_get_cycle_count(void);
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER || defined(__DOXYGEN__)
+/**
+ * Transmits a complete package, e.g. by DMA. Once the last byte
+ * has left the line, turag_feldbus_device_block_transmitted() must be called.
+ *
+ * The functions turag_feldbus_device_transmit_byte(), turag_feldbus_device_start_receive_timeout()
+ * and the functions to activate and deactivate the dre, tx and rx interrupts are not used in this mode.
+ *
+ * @param data		data to send
+ * @param length	number of bytes to send
+ *
+ * \pre Nur benötigt, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER auf 1 definiert ist.
+ */
+extern void turag_feldbus_device_transmit_block(const uint8_t* data, FeldbusSize_t length);
+
+/**
+ * Starts receiving one package into the given buffer, e.g. by DMA.
+ * Once the line is idle for the receive timeout specified in the protocol definition
+ * (e.g. using the receiver timeout or idle line detection of the UART) after at least one
+ * byte was received, turag_feldbus_device_block_received() must be called and
+ * the reception stops until this function is called again.
+ *
+ * Bytes that arrive while no reception is started are discarded.
+ *
+ * @param buffer	destination of the received data
+ * @param size		capacity of buffer
+ *
+ * \pre Nur benötigt, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER auf 1 definiert ist.
+ */
+extern void turag_feldbus_device_start_block_receive(uint8_t* buffer, FeldbusSize_t size);
+#endif
+
 /**
  * Enter light sleep mode, which deactivates itself upon the next interrupt request.
  * This function is always called from within turag_feldbus_do_processing() when
  * there is no packet to be processed.
- *  This function is defined as a weak symbol
- * with empty body and may be overwritten if device supports switching the bus.
+ * 
+ * Implementing this function is optional. Only if it is implemented,
+ * turag_feldbus_do_processing() disables the interrupts between checking for a
+ * package and calling it (see \ref TURAG_FELDBUS_DEVICE_CONFIG_LOCK_FREE_PROCESSING).
  */
 extern void turag_feldbus_device_goto_sleep();
 
@@ -429,6 +477,83 @@ extern uint8_t turag_feldbus_device_read_from_static_storage(uint32_t offset, ui
  */
 extern uint8_t turag_feldbus_device_write_to_static_storage(uint32_t offset, const uint8_t* data, uint16_t size);
 
+/**
+ * Starts writing data to the device's static storage without waiting for
+ * the write to finish. data stays valid until turag_feldbus_device_poll_write_to_static_storage()
+ * reports the end of the write. Offset and size are already checked.
+ * Possible return values:
+ * - 0: write started
+ * - other: error code as returned by turag_feldbus_device_write_to_static_storage()
+ * This function is defined as a weak symbol calling turag_feldbus_device_write_to_static_storage()
+ * and may be overwritten if the storage can be programmed in the background (e.g.
+ * interrupt-driven EEPROM or flash programming).
+ *
+ * \pre Nur benutzt, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE auf 1 definiert
+ * oder \ref TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH größer 0 ist.
+ */
+extern uint8_t turag_feldbus_device_start_write_to_static_storage(uint32_t offset, const uint8_t* data, uint16_t size);
+
+/**
+ * Returns the state of the write started with turag_feldbus_device_start_write_to_static_storage().
+ * Possible return values:
+ * - \ref TURAG_FELDBUS_DEVICE_STORAGE_BUSY: write still in progress
+ * - 0: success
+ * - other: error code as returned by turag_feldbus_device_write_to_static_storage()
+ * This function is called from turag_feldbus_do_processing() and must not block.
+ * It is defined as a weak symbol always returning 0 and has to be overwritten
+ * together with turag_feldbus_device_start_write_to_static_storage().
+ *
+ * \pre Nur benutzt, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE auf 1 definiert
+ * oder \ref TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH größer 0 ist.
+ */
+extern uint8_t turag_feldbus_device_poll_write_to_static_storage(void);
+
+/**
+ * Returns the size of a device specific object that can be read with
+ * \ref TURAG_FELDBUS_DEVICE_COMMAND_READ_SEGMENTED. object is at least
+ * \ref TURAG_FELDBUS_DEVICE_OBJECT_USER_FIRST. A size of 0 means the object does not exist.
+ * This function is defined as a weak symbol returning zero
+ * and may be overwritten if the device provides its own objects.
+ *
+ * \pre Nur benutzt, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER auf 1 definiert ist.
+ */
+extern uint32_t turag_feldbus_device_get_object_size(uint8_t object);
+
+/**
+ * Reads data of a device specific object into the specified buffer.
+ * Offset and size are already checked against turag_feldbus_device_get_object_size().
+ * Possible return values:
+ * - 0: success
+ * - other: error, the package is answered with \ref TURAG_FELDBUS_DEVICE_SEGMENT_ERROR
+ * This function is defined as a weak symbol
+ * always returning 1 and may be overwritten if the device provides its own objects.
+ *
+ * \pre Nur benutzt, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER auf 1 definiert ist.
+ */
+extern uint8_t turag_feldbus_device_read_object(uint8_t object, uint32_t offset, uint16_t size, uint8_t* buffer);
+
+/**
+ * Returns the bus address that was stored with turag_feldbus_device_store_address()
+ * or 0 if there is none. Called by turag_feldbus_device_init().
+ * This function is defined as a weak symbol reading the address from the static
+ * storage at \ref TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS_OFFSET
+ * and may be overwritten if the device stores its address elsewhere.
+ *
+ * \pre Nur benutzt, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS auf 1 definiert ist.
+ */
+extern FeldbusAddress_t turag_feldbus_device_load_address(void);
+
+/**
+ * Stores the bus address, which was changed by a broadcast, so that it survives a reset.
+ * 0 means the device has no address. Called only if the address differs from the stored one.
+ * This function is defined as a weak symbol writing the address and its complement
+ * to the static storage at \ref TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS_OFFSET
+ * and may be overwritten if the device stores its address elsewhere.
+ *
+ * \pre Nur benutzt, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS auf 1 definiert ist.
+ */
+extern void turag_feldbus_device_store_address(FeldbusAddress_t address);
+
 ///@}
 
 
@@ -483,6 +608,30 @@ static inline void turag_feldbus_device_receive_timeout_occured(void);
 static inline void turag_feldbus_device_increase_uptime_counter(void);
 #endif
 
+#if TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER || defined(__DOXYGEN__)
+/**
+ * Block-Receive-Interface.
+ *
+ * Call this function when the reception started with turag_feldbus_device_start_block_receive()
+ * is finished because the line became idle.
+ * @param length Number of received bytes. If more bytes arrived than fitted into the buffer,
+ * any value larger than the size of the buffer can be passed.
+ *
+ * \pre Nur verfügbar, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER auf 1 definiert ist.
+ */
+static inline void turag_feldbus_device_block_received(size_t length);
+
+/**
+ * Block-Transmit-Interface.
+ *
+ * Call this function when the transmission started with turag_feldbus_device_transmit_block()
+ * is complete.
+ *
+ * \pre Nur verfügbar, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER auf 1 definiert ist.
+ */
+static inline void turag_feldbus_device_block_transmitted(void);
+#endif
+
 ///@}
 
 
@@ -492,6 +641,13 @@ static inline void turag_feldbus_device_increase_uptime_counter(void);
 # define TURAG_FELDBUS_NO_ANSWER		<configuration-dependend>
 #endif
 
+/// \brief Rückgabewert für den \ref TuragFeldbusPacketProcessor, mit dem angezeigt wird,
+/// dass die Antwort mit turag_feldbus_device_defer_answer() verzögert wurde.
+/// Nur verfügbar, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE größer 0 ist.
+#if defined(__DOXYGEN__)
+# define TURAG_FELDBUS_DEFERRED_ANSWER		<configuration-dependend>
+#endif
+
 /// \brief Typ, der für Offsets und Längen benutzt wird.
 /// Größe des tatsächlichen Integer-Typs hängt von der Größe
 /// des Puffers ab (\ref TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE)
@@ -500,7 +656,25 @@ typedef int FeldbusSize_t;
 #endif
 
 /// \brief Typ, der für die Device Adresse benutzt wird.
-typedef uint8_t FeldbusAddress_t;
+/// Größe hängt von \ref TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH ab.
+#if defined(__DOXYGEN__)
+typedef int FeldbusAddress_t;
+#endif
+
+/// \brief Master-Adresse mit der konfigurierten Adresslänge.
+/// Antworten werden mit der eigenen Adresse verODERt mit diesem Wert versendet.
+#if TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH == 2
+# define TURAG_FELDBUS_DEVICE_MASTER_ADDR		TURAG_FELDBUS_MASTER_ADDR_2
+#else
+# define TURAG_FELDBUS_DEVICE_MASTER_ADDR		TURAG_FELDBUS_MASTER_ADDR
+#endif
+
+/// \brief Broadcast-Adresse mit der konfigurierten Adresslänge.
+#if TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH == 2
+# define TURAG_FELDBUS_DEVICE_BROADCAST_ADDR	TURAG_FELDBUS_BROADCAST_ADDR_2
+#else
+# define TURAG_FELDBUS_DEVICE_BROADCAST_ADDR	TURAG_FELDBUS_BROADCAST_ADDR
+#endif
 
 
 
@@ -531,6 +705,10 @@ typedef uint8_t FeldbusAddress_t;
  * stripped of address and checksum. message_length is guaranteed to be >= 1 as a consequence 
  * ping-requests (empty package) being handled by this implementation.
  * 
+ * If the answer takes long to compute, it can be deferred with
+ * turag_feldbus_device_defer_answer(). In this case \ref TURAG_FELDBUS_DEFERRED_ANSWER
+ * has to be returned and the master receives an empty package asking it to retry.
+ * 
  * \note Diese Funktion wird stets im main-Kontext aufgerufen.
  *
  * @warning Keinesfalls dürfen in response mehr Daten geschrieben werden als 
@@ -554,6 +732,43 @@ typedef FeldbusSize_t (*TuragFeldbusPacketProcessor)(const uint8_t* message, Fel
  * \note Diese Funktion wird stets im main-Kontext aufgerufen.
  */
 typedef void (*TuragFeldbusBroadcastProcessor)(const uint8_t* message, FeldbusSize_t message_length, uint8_t protocol_id);
+
+
+/**
+ * @param[in] data				Argumente des Befehls, d.h. das empfangene Paket ohne
+ * das einleitende 0x00 und die Befehls-ID.
+ * @param[in] data_length		Anzahl der Argumente, kann 0 sein.
+ * @param[out] response			Puffer für die Antwort.
+ * @return						Länge der Antwort oder \ref TURAG_FELDBUS_NO_ANSWER.
+ *
+ * Bearbeitet ein reserviertes Paket, dessen Befehls-ID mit
+ * turag_feldbus_device_register_command() registriert wurde. Die Länge der
+ * Argumente muss vom Handler selbst geprüft werden.
+ *
+ * \note Diese Funktion wird stets im main-Kontext aufgerufen.
+ *
+ * @warning Keinesfalls dürfen in response mehr Daten geschrieben werden als 
+ * \ref TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - \ref TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH bytes.
+ */
+typedef FeldbusSize_t (*TuragFeldbusCommandHandler)(const uint8_t* data, FeldbusSize_t data_length, uint8_t* response);
+
+
+/**
+ * @param[in] message			Die bisher empfangenen Daten ohne Adresse.
+ * @param[in] length			Anzahl der bisher empfangenen Datenbytes (1 oder 2).
+ * @return						Anzahl der Datenbytes des Pakets ohne Adresse und
+ * Checksumme oder 0, wenn die Länge (noch) nicht feststeht.
+ *
+ * Bestimmt die Länge eines Pakets des Geräteprotokolls aus seinen ersten Bytes,
+ * siehe \ref TURAG_FELDBUS_DEVICE_CONFIG_FRAME_LENGTH_HINTS. Gibt die Funktion
+ * nach dem ersten Byte 0 zurück, wird sie nach dem zweiten erneut aufgerufen.
+ * 
+ * Eine zu kurze Länge führt dazu, dass das Paket abgeschnitten wird. Im Zweifel
+ * muss daher 0 zurückgegeben werden.
+ *
+ * \note Diese Funktion wird im Interrupt-Kontext aufgerufen und muss entsprechend kurz sein.
+ */
+typedef FeldbusSize_t (*TuragFeldbusFrameLengthHint)(const uint8_t* message, FeldbusSize_t length);
 ///@}
 
 
@@ -581,8 +796,136 @@ void turag_feldbus_device_init(
 		TuragFeldbusBroadcastProcessor broadcastProcessor);
 
 
+/**
+ * Beschreibung eines Gerätes, die bereits zur Compile-Zeit feststeht.
+ *
+ * Kann mit turag_feldbus_device_make_extended_info() als konstanter Ausdruck
+ * erzeugt werden und liegt dann zusammen mit der fertigen Antwort auf
+ * \ref TURAG_FELDBUS_DEVICE_COMMAND_GET_EXTENDED_INFO im Flash.
+ */
+typedef struct {
+	/// Antwort auf \ref TURAG_FELDBUS_DEVICE_COMMAND_GET_EXTENDED_INFO:
+	/// 0, Länge des Namens, Länge der Versionsinfo, Puffergröße (little endian),
+	/// Name, Versionsinfo.
+	const uint8_t* extended_info;
+	/// Länge von extended_info.
+	FeldbusSize_t extended_info_length;
+	/// Protokoll-ID des Gerätes.
+	uint8_t device_protocol;
+	/// Geräte-Typ.
+	uint8_t device_type;
+} turag_feldbus_device_descriptor_t;
+
+/**Initialize TURAG Feldbus support with a device descriptor
+ *
+ * Same as turag_feldbus_device_init() but takes name, version info and protocol
+ * from a descriptor that was built at compile time. The device info and
+ * extended info requests are then answered with a single memcpy and
+ * no string lengths need to be determined at startup.
+ *
+ * The descriptor must stay valid as long as the device is running.
+ */
+void turag_feldbus_device_init_descriptor(
+		FeldbusAddress_t bus_address, uint32_t uuid,
+		const turag_feldbus_device_descriptor_t* descriptor,
+		TuragFeldbusPacketProcessor packetProcessor,
+		TuragFeldbusBroadcastProcessor broadcastProcessor);
+
+
 uint32_t turag_feldbus_device_hash_uuid(const uint8_t* key, size_t length);
 
+/**
+ * Registriert einen Handler für ein eigenes reserviertes Paket.
+ * @param command	Befehls-ID ab \ref TURAG_FELDBUS_DEVICE_COMMAND_USER_FIRST
+ * @param handler	Handler, der das Paket bearbeitet, oder 0, um die Registrierung aufzuheben
+ * @return			false, wenn die Befehls-ID außerhalb des konfigurierten Bereichs liegt
+ *
+ * Reservierte Pakete (erstes Datenbyte 0x00) werden über eine Tabelle anhand
+ * der Befehls-ID im zweiten Byte zugeordnet und erreichen den
+ * \ref TuragFeldbusPacketProcessor nicht. Damit können Geräteprotokolle
+ * eigene Diagnosebefehle mit konstantem Aufwand bereitstellen.
+ *
+ * Die Befehls-IDs unterhalb von \ref TURAG_FELDBUS_DEVICE_COMMAND_USER_FIRST sind
+ * dem Basis-Protokoll vorbehalten. Es stehen
+ * \ref TURAG_FELDBUS_DEVICE_CONFIG_USER_COMMAND_COUNT IDs zur Verfügung.
+ *
+ * \note Darf nur im main-Kontext aufgerufen werden.
+ */
+bool turag_feldbus_device_register_command(uint8_t command, TuragFeldbusCommandHandler handler);
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_FRAME_LENGTH_HINTS || defined(__DOXYGEN__)
+/**
+ * Setzt die Funktion, die die Länge der Pakete des Geräteprotokolls bestimmt.
+ * @param hint		Funktion oder 0, wenn nur reservierte Pakete vorzeitig
+ * abgeschlossen werden sollen.
+ *
+ * Nur verfügbar, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_FRAME_LENGTH_HINTS auf 1 gesetzt ist.
+ *
+ * \note Darf nur im main-Kontext aufgerufen werden.
+ */
+void turag_feldbus_device_set_frame_length_hint(TuragFeldbusFrameLengthHint hint);
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE > 0 || defined(__DOXYGEN__)
+/**
+ * Verzögert die Antwort auf das Paket, das gerade bearbeitet wird.
+ * @return			Puffer für die Antwort mit \ref TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE Bytes
+ * oder 0, wenn noch eine andere verzögerte Antwort berechnet wird.
+ *
+ * Darf nur innerhalb des \ref TuragFeldbusPacketProcessor aufgerufen werden, der
+ * anschließend \ref TURAG_FELDBUS_DEFERRED_ANSWER zurückgeben muss. Der Puffer
+ * gehört danach der Firmware, bis turag_feldbus_device_complete_deferred_answer()
+ * aufgerufen wird. Wiederholungen der Anfrage werden bis dahin mit einem leeren
+ * Paket beantwortet.
+ *
+ * Eine fertige Antwort, die der Master nicht mehr abgeholt hat, wird dabei
+ * verworfen.
+ *
+ * Liefert die Funktion 0, kann der Packet-Processor trotzdem
+ * \ref TURAG_FELDBUS_DEFERRED_ANSWER zurückgeben. Der Master erhält dann ein
+ * leeres Paket und die Wiederholung der Anfrage erreicht den Packet-Processor erneut.
+ *
+ * Nur verfügbar, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE größer 0 ist.
+ *
+ * \note Diese Funktion wird stets im main-Kontext aufgerufen.
+ */
+uint8_t* turag_feldbus_device_defer_answer(void);
+
+/**
+ * Stellt die mit turag_feldbus_device_defer_answer() verzögerte Antwort fertig.
+ * @param length	Anzahl der Bytes im Puffer oder \ref TURAG_FELDBUS_NO_ANSWER, um die
+ * Anfrage zu verwerfen. Ihre nächste Wiederholung erreicht dann wieder den Packet-Processor.
+ * Längen über \ref TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE werden wie
+ * \ref TURAG_FELDBUS_NO_ANSWER behandelt.
+ *
+ * Die nächste Wiederholung der Anfrage wird mit dem Inhalt des Puffers beantwortet,
+ * danach ist der Puffer wieder frei. Geht diese Antwort verloren, wird die Anfrage
+ * wie eine neue bearbeitet.
+ *
+ * Nur verfügbar, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE größer 0 ist.
+ *
+ * \note Darf im main-Kontext, aus einem anderen Task oder im Interrupt-Kontext
+ * aufgerufen werden, aber nur einmal je verzögerter Antwort.
+ */
+void turag_feldbus_device_complete_deferred_answer(FeldbusSize_t length);
+#endif
+
+/**
+ * Returns the number of checksum bytes that are appended to a package.
+ * @param length	length of the package (address and data) without checksum
+ *
+ * This is always 1, except for \ref TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+ * where long packages are protected by a CRC16-checksum.
+ */
+static inline FeldbusSize_t turag_feldbus_device_checksum_length(FeldbusSize_t length) {
+#if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+	return length < TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED_MAX_CRC8_LENGTH ? 1 : 2;
+#else
+	(void)length;
+	return 1;
+#endif
+}
+
 /**
  * This function needs to be called continuously from the device's
  * main loop. It handles all advanced communication logic.
@@ -598,12 +941,15 @@ void turag_feldbus_do_processing(void);
 // debugging functions
 #if TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED || defined(__DOXYGEN__)
 /** @name Debug-Functions
- * Diese Funktionen können verwendet werden, um Debugausgaben in Form
- * konventioneller Zeichenketten auf dem Bus auszugeben.
+ * Diese Funktionen können verwendet werden, um Debugausgaben zu erzeugen.
  * 
- * Soll eine der Debug-Funktionen von turag_feldbus_device_process_package()
- * aus aufgerufen werden, kann das Makro TURAG_FELDBUS_DEBUG_SAFE() benutzt werden,
- * welches als Argument den kompletten Funktionsaufruf entgegennimmt.
+ * Die Ausgaben werden nicht formatiert, sondern als kompakte Einträge in einem
+ * Ringpuffer der Größe \ref TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_LOG_SIZE abgelegt,
+ * den der Master mit \ref TURAG_FELDBUS_DEVICE_COMMAND_READ_LOG ausliest und
+ * formatiert. Die Funktionen blockieren nicht und dürfen auch aus
+ * turag_feldbus_device_process_package() oder einem Interrupt aufgerufen werden,
+ * solange sie immer aus demselben Kontext aufgerufen werden. Passt
+ * ein Eintrag nicht mehr in den Puffer, wird er verworfen.
  * 
  * \pre Nur verfügbar, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED auf 1 definiert ist.
  * 
@@ -636,9 +982,9 @@ void turag_feldbus_do_processing(void);
 	/// print unsigned short value in hexadecimal format without trailing newline characters
 	void print_short_nn(uint16_t x);
 	
-	/// Makro, von welchem eine Debug-Funktion umschlossen werden muss, wenn es von 
-	/// turag_feldbus_device_process_package() aus aufgerufen wird.
-	#define TURAG_FELDBUS_DEBUG_SAFE(function) function; while (turag_feldbus_device.transmission_active)
+	/// Makro, von welchem eine Debug-Funktion früher umschlossen werden musste, wenn sie von 
+	/// turag_feldbus_device_process_package() aus aufgerufen wurde. Nur noch aus Kompatibilitätsgründen vorhanden.
+	#define TURAG_FELDBUS_DEBUG_SAFE(function) function
 ///@}
 #else
 # 	define print_text(x)
@@ -655,35 +1001,226 @@ void turag_feldbus_do_processing(void);
 #ifdef __cplusplus
 }
 #endif
+
+
+#if (defined(__cplusplus) && __cplusplus >= 201402L) || defined(__DOXYGEN__)
+/// \brief Fertige Antwort auf \ref TURAG_FELDBUS_DEVICE_COMMAND_GET_EXTENDED_INFO, 
+/// siehe turag_feldbus_device_make_extended_info().
+template<size_t NameSize, size_t VersionSize>
+struct TuragFeldbusExtendedInfo {
+	uint8_t data[5 + (NameSize - 1) + (VersionSize - 1)];
+};
+
+/**
+ * Erzeugt die Antwort auf \ref TURAG_FELDBUS_DEVICE_COMMAND_GET_EXTENDED_INFO zur Compile-Zeit.
+ * @param name		Gerätename (String-Literal)
+ * @param version	Versionsinfo (String-Literal)
+ *
+ * Beispiel:
+ * \code
+ * static constexpr auto extended_info = turag_feldbus_device_make_extended_info("Motor links", "v1.2");
+ * static constexpr turag_feldbus_device_descriptor_t descriptor = {
+ *     extended_info.data, sizeof(extended_info.data),
+ *     TURAG_FELDBUS_DEVICE_PROTOCOL_STELLANTRIEBE, TURAG_FELDBUS_STELLANTRIEBE_DEVICE_TYPE_DC
+ * };
+ * turag_feldbus_device_init_descriptor(address, uuid, &descriptor, process_package, 0);
+ * \endcode
+ *
+ * \pre Nur in C++14 oder neuer verfügbar.
+ */
+template<size_t NameSize, size_t VersionSize>
+constexpr TuragFeldbusExtendedInfo<NameSize, VersionSize> turag_feldbus_device_make_extended_info(const char (&name)[NameSize], const char (&version)[VersionSize]) {
+	static_assert(NameSize - 1 <= 255 && VersionSize - 1 <= 255, "name and version info must not be longer than 255 characters");
+	static_assert(5 + (NameSize - 1) + (VersionSize - 1) <= TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE, "extended info does not fit into TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE");
+
+	TuragFeldbusExtendedInfo<NameSize, VersionSize> info = {};
+	info.data[0] = 0;
+	info.data[1] = NameSize - 1;
+	info.data[2] = VersionSize - 1;
+	info.data[3] = TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE & 0xff;
+	info.data[4] = (TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE >> 8) & 0xff;
+	for (size_t i = 0; i < NameSize - 1; ++i) {
+		info.data[5 + i] = name[i];
+	}
+	for (size_t i = 0; i < VersionSize - 1; ++i) {
+		info.data[5 + (NameSize - 1) + i] = version[i];
+	}
+	return info;
+}
+#endif
 	
 // hide some uninteresting stuff from documentation
 #if (!defined(__DOXYGEN__))
 		
 #define TURAG_FELDBUS_DEVICE_ACTUAL_BUFFER_SIZE  (TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH + TURAG_FELDBUS_DEVICE_CRC_SIZE)
 
+// Segmented reads answer with several packages in a row, separated by the
+// receive timeout. Block transfers have no timer for the gap.
+#define TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW		(TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER && !TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER)
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_XOR
+# define TURAG_FELDBUS_DEVICE_CHECKSUM_INIT	0
+#elif TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8 || TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+# define TURAG_FELDBUS_DEVICE_CHECKSUM_INIT	TURAG_CRC8_INIT
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH > 0
+// payload of a bulk write frame following the reserved package header, sequence number and offset
+# define TURAG_FELDBUS_DEVICE_BULK_WRITE_DATA_SIZE	(TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - 7)
+
+// bulk write frame waiting to be programmed
+typedef struct {
+	uint32_t offset;
+	uint16_t size;
+	uint8_t data[TURAG_FELDBUS_DEVICE_BULK_WRITE_DATA_SIZE];
+} turag_feldbus_device_bulk_write_t;
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+// statistics of one stage of the package processing, in cycles of turag_feldbus_device_get_cycle_count()
+typedef struct {
+	uint32_t min;
+	uint32_t max;
+	// saturating counters, see turag_feldbus_device_profile_add()
+	uint16_t histogram[TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKETS];
+} turag_feldbus_device_profile_t;
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+# define TURAG_FELDBUS_DEVICE_TRACE_HEADER_SIZE	4
+
+// entry of the packet trace, sent as it is by TURAG_FELDBUS_DEVICE_COMMAND_READ_TRACE
+typedef struct {
+	// low 16 bits of the uptime counter
+	uint16_t timestamp;
+	uint8_t length;
+	// TURAG_FELDBUS_DEVICE_TRACE_*
+	uint8_t event;
+	uint8_t header[TURAG_FELDBUS_DEVICE_TRACE_HEADER_SIZE];
+} turag_feldbus_device_trace_t;
+
+// Ring of trace entries with a single writer. The writer only moves head and
+// counts dropped entries, TURAG_FELDBUS_DEVICE_COMMAND_READ_TRACE only moves tail.
+// One entry stays free to tell a full ring from an empty one.
+typedef struct {
+	turag_feldbus_device_trace_t entries[TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH + 1];
+	uint8_t head;
+	uint8_t tail;
+	// entries that did not fit into the ring, wrapping
+	uint8_t dropped;
+} turag_feldbus_device_trace_ring_t;
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+// reserved commands with a packet counter, all base protocol commands need to be covered
+# define TURAG_FELDBUS_DEVICE_STATISTICS_RESERVED_COUNT	32
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE
+// states of an asynchronous static storage write
+# define TURAG_FELDBUS_DEVICE_STORAGE_WRITE_IDLE		0
+# define TURAG_FELDBUS_DEVICE_STORAGE_WRITE_QUEUED		1
+# define TURAG_FELDBUS_DEVICE_STORAGE_WRITE_STARTED		2
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE > 0
+// states of a deferred answer
+# define TURAG_FELDBUS_DEVICE_DEFERRED_IDLE			0
+# define TURAG_FELDBUS_DEVICE_DEFERRED_PENDING		1
+# define TURAG_FELDBUS_DEVICE_DEFERRED_DONE			2
+#endif
+
 typedef struct {
 	// holds the number of bytes in txbuf
 	FeldbusSize_t transmitLength;
 	// offset in txbuf
 	FeldbusSize_t txOffset;
+#if TURAG_FELDBUS_DEVICE_CONFIG_TX_CHECKSUM_IN_ISR
+	// offset at which the checksum is sent instead of the content of txbuf
+	FeldbusSize_t txChecksumOffset;
+	// running checksum of the package being transmitted
+# if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+	uint16_t tx_checksum;
+# else
+	uint8_t tx_checksum;
+# endif
+#endif
 	// offset in rxBuf
 	FeldbusSize_t rxOffset;
-	// if not 0, then there is a package waiting for processsing
-	volatile FeldbusSize_t rx_length;
+	// The receive interrupt hands packages over to turag_feldbus_do_processing()
+	// through rx_ready: it is set with release semantics after the package and
+	// rx_length are written and read with acquire semantics. A single byte is
+	// always accessed atomically, while FeldbusSize_t might not be. So no
+	// interrupt lock is needed for the handoff.
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+	// length of the package in the slot, valid while rx_ready is set
+	FeldbusSize_t rx_length[TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT];
+	// the slot holds a package waiting for processing, cleared once it is processed
+	bool rx_ready[TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT];
+	// slot the receive interrupt writes to
+	uint8_t rx_write_slot;
+	// slot turag_feldbus_do_processing() reads from next
+	uint8_t rx_read_slot;
+	// all slots are occupied, the current package is ignored
+	bool rx_discard;
+	// address of the ignored package, collected to count it as lost if it was for us
+	FeldbusAddress_t rx_discard_address;
+#else
+	// length of the package in rxbuf, valid while rx_ready is set
+	FeldbusSize_t rx_length;
+	// there is a package waiting for processsing
+	bool rx_ready;
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_CHECKSUM_IN_ISR
+	// running checksum of the package being received
+	uint8_t rx_checksum;
+# if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+	// we don't know in advance whether the package is protected by CRC8 or CRC16
+	uint16_t rx_checksum16;
+# endif
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_ADDRESS_FILTER
+	// the package is addressed to another device, the remaining bytes are ignored
+	bool rx_foreign;
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_FRAME_LENGTH_HINTS
+	// length of the current package including address and checksum, 0 if unknown
+	FeldbusSize_t rx_expected_length;
+	TuragFeldbusFrameLengthHint frame_length_hint;
+#endif
 	// overflow detected
 	bool overflow;
 	// package loss detected and counter must be increased
 	bool package_lost_flag;
 	// overflow detected and counter must be increased
 	bool buffer_overflow_flag;
-#if TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED
-	volatile bool transmission_active;
+	// txbuf is in use by a running transmission, cleared by the transmit interrupt
+	bool transmission_active;
+#if TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER
+	// turag_feldbus_device_start_block_receive() was called and the reception is not finished yet
+	bool rx_block_started;
 #endif
-	volatile bool toggleLedBlocked;
+	bool toggleLedBlocked;
 	TuragFeldbusPacketProcessor packet_processor;
 	TuragFeldbusBroadcastProcessor broadcast_processor;
 	// bus address of the device
 	FeldbusAddress_t my_address;
+#if TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH == 2 && TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+	// Copies of my_address for the receive interrupt, which keeps running while
+	// a package is processed. 8-bit MCUs cannot write 2 bytes atomically, so
+	// the main loop writes the unused copy and then switches rx_address_index.
+	FeldbusAddress_t rx_address[2];
+	uint8_t rx_address_index;
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS
+	// bus address in the static storage
+	FeldbusAddress_t persisted_address;
+#endif
+	// precomputed response to the device info request
+	uint8_t device_info[11];
+	// precomputed response to TURAG_FELDBUS_DEVICE_COMMAND_GET_EXTENDED_INFO or 0
+	const uint8_t* extended_info;
+	FeldbusSize_t extended_info_length;
 	const char* name;
 	size_t name_length;
 	const char* versioninfo;
@@ -695,10 +1232,128 @@ typedef struct {
 	uint32_t packagecount_lost;
 	uint32_t packagecount_chksum_mismatch;
 	uint32_t uptime_counter;
+#if TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW
+	// object of the running segmented read
+	uint8_t segment_object;
+	// number of segments that still need to be sent for the current request
+	uint8_t segment_remaining;
+	// sequence number of the next segment
+	uint8_t segment_sequence;
+	// set by the receive timeout after the previous segment, the bus was idle long
+	// enough for the master to tell the packages apart
+	bool segment_gap;
+	// position of the next segment in the object
+	uint32_t segment_offset;
+	// size of the object
+	uint32_t segment_object_size;
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH > 0
+	// accepted bulk write frames that are not programmed yet
+	turag_feldbus_device_bulk_write_t bulk_queue[TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH];
+	// index of the oldest frame in bulk_queue
+	uint8_t bulk_queue_head;
+	// number of frames in bulk_queue
+	uint8_t bulk_queue_count;
+	// sequence number of the next frame that will be accepted
+	uint8_t bulk_expected_sequence;
+	// sequence number of the next frame that will be programmed
+	uint8_t bulk_written_sequence;
+	// error code of the first failed frame, no more frames are accepted until restart
+	uint8_t bulk_error;
+	// the oldest frame is being programmed with turag_feldbus_device_start_write_to_static_storage()
+	bool bulk_write_started;
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE
+	// TURAG_FELDBUS_DEVICE_STORAGE_WRITE_*
+	uint8_t storage_write_state;
+	// result of the last write or TURAG_FELDBUS_DEVICE_STORAGE_BUSY
+	uint8_t storage_write_result;
+	uint16_t storage_write_size;
+	uint32_t storage_write_offset;
+	// copy of the data, the write might outlast rxbuf
+	uint8_t storage_write_data[TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - 6];
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE > 0
+	// TURAG_FELDBUS_DEVICE_DEFERRED_*, set to DONE with release semantics
+	// by turag_feldbus_device_complete_deferred_answer() from any context
+	uint8_t deferred_state;
+	// length of the answer, valid in state DONE
+	FeldbusSize_t deferred_length;
+	// recognizes repetitions of the deferred request
+	FeldbusSize_t deferred_request_length;
+	uint32_t deferred_request_hash;
+	// request the packet processor is working on, 0 outside of it
+	const uint8_t* current_request;
+	FeldbusSize_t current_request_length;
+	uint8_t deferred_answer[TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE];
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+	// indexed by TURAG_FELDBUS_DEVICE_PROFILE_*
+	turag_feldbus_device_profile_t profile[TURAG_FELDBUS_DEVICE_PROFILE_STAGE_COUNT];
+	// time the package in each rx slot was completed
+	uint32_t rx_timestamp[TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT];
+	// time the transmission of txbuf was started
+	uint32_t tx_timestamp;
+	// Duration of the last transmission. The transmit interrupt hands it over
+	// to turag_feldbus_do_processing(), so only the main loop writes profile.
+	uint32_t tx_duration;
+	bool tx_duration_ready;
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+	// number of bytes of the package being received, including those that are not stored
+	uint16_t rx_frame_length;
+	// address of the package being received
+	FeldbusAddress_t rx_frame_address;
+	// Only the receive interrupt writes rx_bytes and foreign_bytes. It makes
+	// rx_bytes_sequence odd while it updates them, so the main loop can take
+	// a consistent snapshot without locking, see turag_feldbus_device_count_rx_bytes().
+	uint8_t rx_bytes_sequence;
+	uint32_t rx_bytes;
+	// received bytes of packages addressed to other devices
+	uint32_t foreign_bytes;
+	// counters at the last reset, the interrupt never resets them
+	uint32_t rx_bytes_reset;
+	uint32_t foreign_bytes_reset;
+	uint32_t tx_bytes;
+	uint16_t broadcast_count;
+	// device info requests and reserved packets without a counter of their own
+	uint16_t other_reserved_count;
+	// indexed by command id
+	uint16_t reserved_count[TURAG_FELDBUS_DEVICE_STATISTICS_RESERVED_COUNT];
+	// indexed by the first byte of the package, 0 counts the rest
+	uint16_t protocol_count[TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS_COMMANDS];
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED
+	// Ring of debug records. The debug functions only write debug_log_head and
+	// debug_log_dropped, TURAG_FELDBUS_DEVICE_COMMAND_READ_LOG only writes
+	// debug_log_tail and debug_log_dropped_read, so no locking is required.
+	uint8_t debug_log[TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_LOG_SIZE];
+	uint8_t debug_log_head;
+	uint8_t debug_log_tail;
+	uint8_t debug_log_dropped;
+	uint8_t debug_log_dropped_read;
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+	// The interrupts and the main loop record into rings of their own,
+	// so no locking is required.
+	turag_feldbus_device_trace_ring_t trace_isr;
+	turag_feldbus_device_trace_ring_t trace_main;
+	// trace_isr.head at the time each entry of trace_main was written,
+	// restores the order of both rings
+	uint8_t trace_main_isr_head[TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH + 1];
+	// sum of the dropped counters of both rings at the last TURAG_FELDBUS_DEVICE_COMMAND_READ_TRACE
+	uint8_t trace_dropped_read;
+#endif
 	// uuid of the device
 	uint8_t uuid[4] __attribute__((aligned(4)));
 	uint8_t txbuf[TURAG_FELDBUS_DEVICE_ACTUAL_BUFFER_SIZE] __attribute__((aligned(4)));
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+	// slot the receive interrupt writes to (points into rx_slots)
+	uint8_t* rxbuf;
+	uint8_t rx_slots[TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT][TURAG_FELDBUS_DEVICE_ACTUAL_BUFFER_SIZE] __attribute__((aligned(4)));
+#else
 	uint8_t rxbuf[TURAG_FELDBUS_DEVICE_ACTUAL_BUFFER_SIZE] __attribute__((aligned(4)));
+#endif
 } turag_feldbus_device_t;
 
 
@@ -714,16 +1369,165 @@ extern turag_feldbus_device_t turag_feldbus_device;
 extern "C" {
 #endif
 
+#if (!defined(__DOXYGEN__))
+// adds one byte to a running checksum of the configured type
+static inline uint8_t turag_feldbus_device_checksum_update(uint8_t checksum, uint8_t data) {
+# if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_XOR
+	return xor_checksum_update(checksum, data);
+# elif TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8 || TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+	return turag_crc8_update(checksum, data);
+# endif
+}
+
+// reads the bus address at the beginning of a package. 2-byte addresses
+// are transmitted msb first, so the master bit is always in the first byte.
+static inline FeldbusAddress_t turag_feldbus_device_get_address(const uint8_t* package) {
+# if TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH == 2
+	return ((FeldbusAddress_t)package[0] << 8) | package[1];
+# else
+	return package[0];
+# endif
+}
+
+// writes the bus address to the beginning of a package
+static inline void turag_feldbus_device_put_address(uint8_t* package, FeldbusAddress_t address) {
+# if TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH == 2
+	package[0] = address >> 8;
+	package[1] = address & 0xff;
+# else
+	package[0] = address;
+# endif
+}
+
+// bus address of the device as seen from interrupt context
+static inline FeldbusAddress_t turag_feldbus_device_rx_address(void) {
+# if TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH == 2 && TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+	return turag_feldbus_device.rx_address[__atomic_load_n(&turag_feldbus_device.rx_address_index, __ATOMIC_ACQUIRE)];
+# else
+	return turag_feldbus_device.my_address;
+# endif
+}
+
+// returns true if a package with this address needs to be processed by us
+static inline bool turag_feldbus_device_is_own_address(FeldbusAddress_t address) {
+	return address == turag_feldbus_device_rx_address() || address == TURAG_FELDBUS_DEVICE_BROADCAST_ADDR;
+}
+
+# if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+// adds a received frame to the byte counters. Only to be called in interrupt context.
+static inline void turag_feldbus_device_count_rx_bytes(uint16_t length, bool foreign) {
+	uint8_t sequence = turag_feldbus_device.rx_bytes_sequence;
+	__atomic_store_n(&turag_feldbus_device.rx_bytes_sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	turag_feldbus_device.rx_bytes += length;
+	if (foreign) {
+		turag_feldbus_device.foreign_bytes += length;
+	}
+	__atomic_store_n(&turag_feldbus_device.rx_bytes_sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+# endif
+
+# if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+static inline uint8_t turag_feldbus_device_trace_next(uint8_t index) {
+	return index == TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH ? 0 : index + 1;
+}
+
+// adds an event to a trace ring. Must only be called by the owner of the ring.
+// If the ring is full, the event is dropped, so entries that are being read are never overwritten.
+static inline void turag_feldbus_device_trace_write(turag_feldbus_device_trace_ring_t* ring, uint8_t event, const uint8_t* package, FeldbusSize_t length) {
+	uint8_t head = ring->head;
+	uint8_t next = turag_feldbus_device_trace_next(head);
+	if (next == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) {
+		__atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELEASE);
+		return;
+	}
+
+	turag_feldbus_device_trace_t* entry = &ring->entries[head];
+	entry->timestamp = (uint16_t)turag_feldbus_device.uptime_counter;
+#  if TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE > 255
+	entry->length = length > 255 ? 255 : length;
+#  else
+	entry->length = length;
+#  endif
+	entry->event = event;
+	for (uint8_t i = 0; i < TURAG_FELDBUS_DEVICE_TRACE_HEADER_SIZE; ++i) {
+		entry->header[i] = i < length ? package[i] : 0;
+	}
+
+	// publish the entry
+	__atomic_store_n(&ring->head, next, __ATOMIC_RELEASE);
+}
+
+// adds an event to the packet trace. Only to be called in interrupt context.
+static inline void turag_feldbus_device_trace(uint8_t event, const uint8_t* package, FeldbusSize_t length) {
+	turag_feldbus_device_trace_write(&turag_feldbus_device.trace_isr, event, package, length);
+}
+# endif
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_FRAME_LENGTH_HINTS
+// returns the length of the package including address and checksum as told by
+// its first data bytes or 0 if it is not known (yet)
+FeldbusSize_t turag_feldbus_device_expected_frame_length(const uint8_t* package, FeldbusSize_t received);
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE > 0
+// implemented in feldbus_coroutine.cpp: true if the suspended coroutine handler can continue
+bool turag_feldbus_device_coroutine_ready(void);
+// continues the suspended coroutine handler and completes the deferred answer once it returns
+void turag_feldbus_device_resume_coroutine(void);
+#endif
+
 static inline void turag_feldbus_device_byte_received(uint8_t data) {
-	// if at this point rx_length is not 0, obviously the last 
+#if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+	// the package is counted by turag_feldbus_device_receive_timeout_occured(),
+	// the address tells whether it belongs to another device
+	if (turag_feldbus_device.rx_frame_length < TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH) {
+		turag_feldbus_device.rx_frame_address = (turag_feldbus_device.rx_frame_address << 8) | data;
+	}
+	++turag_feldbus_device.rx_frame_length;
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+	// The first byte of a package decides whether we can store it:
+	// if the slot we would write to still holds a package that was not
+	// processed yet, all slots are occupied. In this case we keep
+	// the pending packages and ignore the new one instead. It is
+	// only counted as lost if it was meant for us.
+	if (turag_feldbus_device.rxOffset == 0) {
+		turag_feldbus_device.rx_discard = __atomic_load_n(&turag_feldbus_device.rx_ready[turag_feldbus_device.rx_write_slot], __ATOMIC_ACQUIRE);
+	}
+	if (turag_feldbus_device.rx_discard) {
+		if (turag_feldbus_device.rxOffset < TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH) {
+			turag_feldbus_device.rx_discard_address = (turag_feldbus_device.rx_discard_address << 8) | data;
+			++turag_feldbus_device.rxOffset;
+			if (turag_feldbus_device.rxOffset == TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH &&
+					turag_feldbus_device_is_own_address(turag_feldbus_device.rx_discard_address)) {
+				turag_feldbus_device.package_lost_flag = true;
+			}
+		}
+		turag_feldbus_device_start_receive_timeout();
+		return;
+	}
+#else
+	// if at this point rx_ready is set, obviously the last 
 	// received package was not processed yet. This package
 	// will be overwritten now and is lost.
-	// Once rx_length is cleared, turag_feldbus_do_processing() will no longer
+	// Once rx_ready is cleared, turag_feldbus_do_processing() will no longer
 	// try to copy packages from the in-buffer.
-	if (turag_feldbus_device.rx_length) {
-		turag_feldbus_device.rx_length = 0;
+	if (__atomic_load_n(&turag_feldbus_device.rx_ready, __ATOMIC_RELAXED)) {
+		__atomic_store_n(&turag_feldbus_device.rx_ready, false, __ATOMIC_RELAXED);
 		turag_feldbus_device.package_lost_flag = true;
 	}
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_ADDRESS_FILTER
+	// packages for other devices are only followed until they end
+	if (turag_feldbus_device.rx_foreign) {
+		turag_feldbus_device_start_receive_timeout();
+		return;
+	}
+#endif
 
 	// We need to check for overflow before actually storing the received
 	// byte. Otherwise we always get an overflow when the last byte in the
@@ -736,7 +1540,7 @@ static inline void turag_feldbus_device_byte_received(uint8_t data) {
 		// If the package was for us, we increase the counter for 
 		// package overflow.
 		if (!turag_feldbus_device.overflow) {
-			if (*((FeldbusAddress_t*)turag_feldbus_device.rxbuf) == turag_feldbus_device.my_address || *((FeldbusAddress_t*)turag_feldbus_device.rxbuf) == TURAG_FELDBUS_BROADCAST_ADDR)
+			if (turag_feldbus_device_is_own_address(turag_feldbus_device_get_address(turag_feldbus_device.rxbuf)))
 			{
 				turag_feldbus_device.buffer_overflow_flag = true;
 			}
@@ -749,14 +1553,81 @@ static inline void turag_feldbus_device_byte_received(uint8_t data) {
 	turag_feldbus_device.rxbuf[turag_feldbus_device.rxOffset] = data;
 	++turag_feldbus_device.rxOffset;
 
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_ADDRESS_FILTER
+	// as soon as the address is complete we know whether we need the rest of the package
+	if (turag_feldbus_device.rxOffset == TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH &&
+			!turag_feldbus_device.overflow &&
+			!turag_feldbus_device_is_own_address(turag_feldbus_device_get_address(turag_feldbus_device.rxbuf))) {
+		turag_feldbus_device.rx_foreign = true;
+	}
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_CHECKSUM_IN_ISR
+	turag_feldbus_device.rx_checksum = turag_feldbus_device_checksum_update(turag_feldbus_device.rx_checksum, data);
+# if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+	turag_feldbus_device.rx_checksum16 = turag_crc16_update(turag_feldbus_device.rx_checksum16, data);
+# endif
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_FRAME_LENGTH_HINTS
+	// The first data bytes may tell the length of the package. Then it is
+	// complete with its last byte and we do not need to wait for the timeout.
+	// The timer is not stopped, when it expires nothing is left to do.
+	if (!turag_feldbus_device.overflow) {
+		if (turag_feldbus_device.rx_expected_length == 0 &&
+				(turag_feldbus_device.rxOffset == TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH + 1 ||
+				turag_feldbus_device.rxOffset == TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH + 2)) {
+			turag_feldbus_device.rx_expected_length = turag_feldbus_device_expected_frame_length(turag_feldbus_device.rxbuf, turag_feldbus_device.rxOffset);
+		} else if (turag_feldbus_device.rxOffset == turag_feldbus_device.rx_expected_length) {
+			turag_feldbus_device_receive_timeout_occured();
+			return;
+		}
+	}
+#endif
+
 	// activate timer to recognize end of command
 	turag_feldbus_device_start_receive_timeout();
 }
 
 static inline void turag_feldbus_device_ready_to_transmit() {
+#if TURAG_FELDBUS_DEVICE_CONFIG_TX_CHECKSUM_IN_ISR
+	// the checksum is calculated while the package is being transmitted
+	// and sent after the last data byte.
+# if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+	// long packages are protected by CRC16 which is sent msb first
+	bool crc16 = turag_feldbus_device.txChecksumOffset >= TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED_MAX_CRC8_LENGTH;
+
+	if (turag_feldbus_device.txOffset >= turag_feldbus_device.txChecksumOffset) {
+		if (!crc16) {
+			turag_feldbus_device_transmit_byte(turag_feldbus_device.tx_checksum);
+		} else if (turag_feldbus_device.txOffset == turag_feldbus_device.txChecksumOffset) {
+			turag_feldbus_device_transmit_byte(turag_feldbus_device.tx_checksum >> 8);
+		} else {
+			turag_feldbus_device_transmit_byte(turag_feldbus_device.tx_checksum & 0xff);
+		}
+	} else {
+		uint8_t data = turag_feldbus_device.txbuf[turag_feldbus_device.txOffset];
+		turag_feldbus_device_transmit_byte(data);
+		if (crc16) {
+			turag_feldbus_device.tx_checksum = turag_crc16_update(turag_feldbus_device.tx_checksum, data);
+		} else {
+			turag_feldbus_device.tx_checksum = turag_crc8_update(turag_feldbus_device.tx_checksum, data);
+		}
+	}
+# else
+	if (turag_feldbus_device.txOffset == turag_feldbus_device.txChecksumOffset) {
+		turag_feldbus_device_transmit_byte(turag_feldbus_device.tx_checksum);
+	} else {
+		uint8_t data = turag_feldbus_device.txbuf[turag_feldbus_device.txOffset];
+		turag_feldbus_device_transmit_byte(data);
+		turag_feldbus_device.tx_checksum = turag_feldbus_device_checksum_update(turag_feldbus_device.tx_checksum, data);
+	}
+# endif
+#else
 	// accessing the buffer as an array is more effective than using a pointer
 	// and increasing it.
 	turag_feldbus_device_transmit_byte(turag_feldbus_device.txbuf[turag_feldbus_device.txOffset]);
+#endif
 	++turag_feldbus_device.txOffset;
 
 	if (turag_feldbus_device.txOffset == turag_feldbus_device.transmitLength) {
@@ -771,8 +1642,16 @@ static inline void turag_feldbus_device_transmission_complete() {
 	turag_feldbus_device_deactivate_tx_interrupt();
 	turag_feldbus_device_activate_rx_interrupt();
 
-#if TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED
-	turag_feldbus_device.transmission_active = false;
+	__atomic_store_n(&turag_feldbus_device.transmission_active, false, __ATOMIC_RELEASE);
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+	turag_feldbus_device.tx_duration = turag_feldbus_device_get_cycle_count() - turag_feldbus_device.tx_timestamp;
+	__atomic_store_n(&turag_feldbus_device.tx_duration_ready, true, __ATOMIC_RELEASE);
+#endif
+#if TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW
+	// the next segment is sent after the bus was idle for the receive timeout
+	if (turag_feldbus_device.segment_remaining) {
+		turag_feldbus_device_start_receive_timeout();
+	}
 #endif
 }
 
@@ -781,31 +1660,197 @@ static inline void turag_feldbus_device_receive_timeout_occured() {
 	if (turag_feldbus_device.package_lost_flag) {
 		++turag_feldbus_device.packagecount_lost;
 		turag_feldbus_device.package_lost_flag = false;
+#if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+		turag_feldbus_device_trace(TURAG_FELDBUS_DEVICE_TRACE_LOST, 0, 0);
+#endif
 	}
 	
 	if (turag_feldbus_device.buffer_overflow_flag) {
 		++turag_feldbus_device.packagecount_buffer_overflow;
 		turag_feldbus_device.buffer_overflow_flag = false;
+#if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+		turag_feldbus_device_trace(TURAG_FELDBUS_DEVICE_TRACE_OVERFLOW, 0, 0);
+#endif
 	}
 
-	if ((*((FeldbusAddress_t*)turag_feldbus_device.rxbuf) == turag_feldbus_device.my_address || *((FeldbusAddress_t*)turag_feldbus_device.rxbuf) == TURAG_FELDBUS_BROADCAST_ADDR) &&
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+	if (turag_feldbus_device.rx_discard) {
+		turag_feldbus_device.rx_discard = false;
+	} else
+#endif
+	if (turag_feldbus_device.rxOffset > TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH &&
 			!turag_feldbus_device.overflow &&
-			turag_feldbus_device.rxOffset > 1)
+			turag_feldbus_device_is_own_address(turag_feldbus_device_get_address(turag_feldbus_device.rxbuf)))
 	{
-		// package ok -> signal main loop that we have package ready
-		turag_feldbus_device.rx_length = turag_feldbus_device.rxOffset;
-		
-		// we stop the led blinking until the user program starts the package
-		// processing
-		turag_feldbus_device.toggleLedBlocked = true;
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_CHECKSUM_IN_ISR
+		// the checksum was updated with every received byte. Adding the
+		// checksum of a correct package to it yields 0.
+# if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+		if (turag_feldbus_device.rxOffset <= TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED_MAX_CRC8_LENGTH ?
+				turag_feldbus_device.rx_checksum != 0 : turag_feldbus_device.rx_checksum16 != 0) {
+# else
+		if (turag_feldbus_device.rx_checksum != 0) {
+# endif
+			++turag_feldbus_device.packagecount_chksum_mismatch;
+# if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+			turag_feldbus_device_trace(TURAG_FELDBUS_DEVICE_TRACE_CHECKSUM_ERROR, turag_feldbus_device.rxbuf, turag_feldbus_device.rxOffset);
+# endif
+		} else
+#endif
+		{
+#if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+			turag_feldbus_device_trace(TURAG_FELDBUS_DEVICE_TRACE_RECEIVED, turag_feldbus_device.rxbuf, turag_feldbus_device.rxOffset);
+#endif
+			// we stop the led blinking until the user program starts the package
+			// processing
+			__atomic_store_n(&turag_feldbus_device.toggleLedBlocked, true, __ATOMIC_RELAXED);
+
+			// package ok -> signal main loop that we have package ready
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+			// and continue with the next slot
+			uint8_t slot = turag_feldbus_device.rx_write_slot;
+			turag_feldbus_device.rx_length[slot] = turag_feldbus_device.rxOffset;
+# if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+			turag_feldbus_device.rx_timestamp[slot] = turag_feldbus_device_get_cycle_count();
+# endif
+			__atomic_store_n(&turag_feldbus_device.rx_ready[slot], true, __ATOMIC_RELEASE);
+			++slot;
+			if (slot == TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT) {
+				slot = 0;
+			}
+			turag_feldbus_device.rx_write_slot = slot;
+			turag_feldbus_device.rxbuf = turag_feldbus_device.rx_slots[slot];
+#else
+			turag_feldbus_device.rx_length = turag_feldbus_device.rxOffset;
+# if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+			turag_feldbus_device.rx_timestamp[0] = turag_feldbus_device_get_cycle_count();
+# endif
+			__atomic_store_n(&turag_feldbus_device.rx_ready, true, __ATOMIC_RELEASE);
+#endif
+		}
 	}
 
 	// reset rxOffset and overflow-flag to ensure correct
 	// receiving of future packages
 	turag_feldbus_device.rxOffset = 0;
 	turag_feldbus_device.overflow = 0;
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_ADDRESS_FILTER
+	turag_feldbus_device.rx_foreign = false;
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_FRAME_LENGTH_HINTS
+	turag_feldbus_device.rx_expected_length = 0;
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+	turag_feldbus_device_count_rx_bytes(turag_feldbus_device.rx_frame_length,
+		turag_feldbus_device.rx_frame_length >= TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH &&
+		!turag_feldbus_device_is_own_address(turag_feldbus_device.rx_frame_address));
+	turag_feldbus_device.rx_frame_length = 0;
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_RX_CHECKSUM_IN_ISR
+	turag_feldbus_device.rx_checksum = TURAG_FELDBUS_DEVICE_CHECKSUM_INIT;
+# if TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE == TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
+	turag_feldbus_device.rx_checksum16 = TURAG_CRC16_INIT;
+# endif
+#endif
+#if TURAG_FELDBUS_DEVICE_SEGMENT_WINDOW
+	// a package from the master arriving instead is processed before the next segment
+	__atomic_store_n(&turag_feldbus_device.segment_gap, true, __ATOMIC_RELEASE);
+#endif
+}
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER
+// starts the reception of the next package if there is a free buffer
+static inline void turag_feldbus_device_continue_block_receive(void) {
+	if (turag_feldbus_device.rx_block_started) {
+		return;
+	}
+# if TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+	if (__atomic_load_n(&turag_feldbus_device.rx_ready[turag_feldbus_device.rx_write_slot], __ATOMIC_ACQUIRE)) {
+		// all slots occupied. turag_feldbus_do_processing() tries again
+		// after releasing one.
+		return;
+	}
+# endif
+	turag_feldbus_device.rx_block_started = true;
+	turag_feldbus_device_start_block_receive(turag_feldbus_device.rxbuf, TURAG_FELDBUS_DEVICE_ACTUAL_BUFFER_SIZE);
 }
 
+static inline void turag_feldbus_device_block_received(size_t length) {
+	turag_feldbus_device.rx_block_started = false;
+
+	bool for_us = length >= TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH &&
+			turag_feldbus_device_is_own_address(turag_feldbus_device_get_address(turag_feldbus_device.rxbuf));
+
+# if TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+	// the length of packages that did not fit into the buffer is unknown
+	size_t counted_length = length > TURAG_FELDBUS_DEVICE_ACTUAL_BUFFER_SIZE ? TURAG_FELDBUS_DEVICE_ACTUAL_BUFFER_SIZE : length;
+	turag_feldbus_device_count_rx_bytes(counted_length, length >= TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH && !for_us);
+# endif
+
+	if (length > TURAG_FELDBUS_DEVICE_ACTUAL_BUFFER_SIZE) {
+		if (for_us) {
+			++turag_feldbus_device.packagecount_buffer_overflow;
+# if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+			turag_feldbus_device_trace(TURAG_FELDBUS_DEVICE_TRACE_OVERFLOW, 0, 0);
+# endif
+		}
+	} else if (for_us && length > TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH) {
+# if TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH > 0
+		turag_feldbus_device_trace(TURAG_FELDBUS_DEVICE_TRACE_RECEIVED, turag_feldbus_device.rxbuf, length);
+# endif
+		// we stop the led blinking until the user program starts the package
+		// processing
+		__atomic_store_n(&turag_feldbus_device.toggleLedBlocked, true, __ATOMIC_RELAXED);
+
+		// package ok -> signal main loop that we have package ready
+# if TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT > 1
+		// and continue with the next slot
+		uint8_t slot = turag_feldbus_device.rx_write_slot;
+		turag_feldbus_device.rx_length[slot] = length;
+#  if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+		turag_feldbus_device.rx_timestamp[slot] = turag_feldbus_device_get_cycle_count();
+#  endif
+		__atomic_store_n(&turag_feldbus_device.rx_ready[slot], true, __ATOMIC_RELEASE);
+		++slot;
+		if (slot == TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT) {
+			slot = 0;
+		}
+		turag_feldbus_device.rx_write_slot = slot;
+		turag_feldbus_device.rxbuf = turag_feldbus_device.rx_slots[slot];
+# else
+		turag_feldbus_device.rx_length = length;
+#  if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+		turag_feldbus_device.rx_timestamp[0] = turag_feldbus_device_get_cycle_count();
+#  endif
+		__atomic_store_n(&turag_feldbus_device.rx_ready, true, __ATOMIC_RELEASE);
+# endif
+
+# if TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT == 1
+		// the only buffer is occupied until the package was processed
+		return;
+# endif
+	}
+
+	turag_feldbus_device_continue_block_receive();
+}
+
+static inline void turag_feldbus_device_block_transmitted(void) {
+	// release bus
+	turag_feldbus_device_rts_off();
+
+	__atomic_store_n(&turag_feldbus_device.transmission_active, false, __ATOMIC_RELEASE);
+# if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+	turag_feldbus_device.tx_duration = turag_feldbus_device_get_cycle_count() - turag_feldbus_device.tx_timestamp;
+	__atomic_store_n(&turag_feldbus_device.tx_duration_ready, true, __ATOMIC_RELEASE);
+# endif
+
+# if TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT == 1
+	// the package we answered to is processed, so the buffer is free again
+	turag_feldbus_device_continue_block_receive();
+# endif
+}
+#endif
+
 static inline void turag_feldbus_device_increase_uptime_counter(void) {
 	++turag_feldbus_device.uptime_counter;
 
@@ -813,7 +1858,7 @@ static inline void turag_feldbus_device_increase_uptime_counter(void) {
 	// waiting to be processsed.
 	// We use this as an indicator for the user whether
 	// there is something wrong with the communication.
-	if (!turag_feldbus_device.toggleLedBlocked) {
+	if (!__atomic_load_n(&turag_feldbus_device.toggleLedBlocked, __ATOMIC_RELAXED)) {
 #  if TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY >= 12
 #   define COUNT_MAX (TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY / 12 - 1)
 #    if COUNT_MAX > 255
@@ -40,7 +40,7 @@
  * 
  * Mögliche Werte:
  * - \ref TURAG_FELDBUS_CHECKSUM_CRC8
- * - \ref TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED  (not yet implemented)
+ * - \ref TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED
  */
 #define TURAG_FELDBUS_DEVICE_CONFIG_CRC_TYPE 	TURAG_FELDBUS_CHECKSUM_CRC8
 
@@ -58,6 +58,18 @@
  */
 #define TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED		0
 
+/**
+ * Size of the buffer for debug output in bytes (optional, Standardwert: 128).
+ *
+ * The debug functions store their output in this buffer until the master
+ * reads it with \ref TURAG_FELDBUS_DEVICE_COMMAND_READ_LOG. Output that
+ * does not fit is dropped. Only used if \ref TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_ENABLED
+ * is set to 1.
+ *
+ * Gültige Werte: 8-255
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_LOG_SIZE		128
+
 
 /**
  * Legt die Frequenz[Hz] fest, mit der turag_feldbus_slave_increase_uptime_counter()
@@ -71,6 +83,392 @@
 #define TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY			50
 
 
+/**
+ * Länge der Busadresse in Byte (optional, Standardwert: 1).
+ *
+ * Mit 1-Byte-Adressen sind die Geräteadressen 1-127 verfügbar. Mit einem Wert
+ * von 2 wird die Adresse als 16-Bit-Wert mit dem höherwertigen Byte zuerst
+ * übertragen und es stehen die Adressen 1-32767 zur Verfügung. Antworten an den
+ * Master werden dann mit \ref TURAG_FELDBUS_MASTER_ADDR_2 gekennzeichnet, Broadcasts
+ * gehen an \ref TURAG_FELDBUS_BROADCAST_ADDR_2.
+ *
+ * Alle Geräte an einem Bus müssen dieselbe Adresslänge benutzen.
+ *
+ * Gültige Werte: 1, 2
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH			1
+
+
+/**
+ * Anzahl der Empfangspuffer (optional, Standardwert: 1).
+ *
+ * Bei einem Wert von 1 wird der Empfangs-Interrupt während der
+ * Bearbeitung eines Paketes deaktiviert. Kommt turag_feldbus_do_processing()
+ * nicht rechtzeitig zum Zug, wird ein noch nicht bearbeitetes Paket vom
+ * nächsten Paket auf dem Bus überschrieben und geht verloren.
+ *
+ * Bei einem Wert größer 1 werden die Puffer als Ring benutzt: während
+ * ein Paket bearbeitet wird, empfängt der Interrupt bereits in den
+ * nächsten freien Puffer. Erst wenn alle Puffer belegt sind, werden
+ * weitere Pakete verworfen. Jeder zusätzliche Puffer kostet
+ * etwas mehr als \ref TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE Byte RAM.
+ *
+ * Gültige Werte: 1-255
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT			1
+
+
+/**
+ * Checksumme bereits im Empfangs-Interrupt berechnen (optional, Standardwert: 0).
+ *
+ * Ist diese Option auf 1 gesetzt, aktualisiert turag_feldbus_device_byte_received()
+ * die Checksumme mit jedem empfangenen Byte. Das Paket wird damit bereits in
+ * turag_feldbus_device_receive_timeout_occured() mit konstantem Aufwand geprüft
+ * und turag_feldbus_do_processing() kann ohne erneuten Durchlauf über den
+ * Puffer sofort mit der Bearbeitung beginnen. Pakete mit falscher Checksumme
+ * werden gar nicht erst an die Hauptschleife übergeben.
+ *
+ * Dafür wird jeder Aufruf des Empfangs-Interrupts etwas länger.
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_RX_CHECKSUM_IN_ISR		0
+
+
+/**
+ * Pakete anderer Geräte im Empfangs-Interrupt ausfiltern (optional, Standardwert: 0).
+ *
+ * Ist diese Option auf 1 gesetzt, entscheidet turag_feldbus_device_byte_received()
+ * direkt nach dem Empfang der Adresse, ob das Paket für dieses Gerät bestimmt ist.
+ * Die restlichen Bytes fremder Pakete werden nicht mehr in den Empfangspuffer
+ * geschrieben und nicht in die Checksumme eingerechnet, sondern nur noch
+ * zum Erkennen des Paketendes benutzt.
+ *
+ * Das lohnt sich vor allem an Bussen mit vielen Geräten, auf denen der Großteil
+ * des Verkehrs an andere Geräte gerichtet ist. Hat mit
+ * \ref TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER keine Wirkung.
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_RX_ADDRESS_FILTER		0
+
+
+/**
+ * Paketende anhand der Länge erkennen (optional, Standardwert: 0).
+ *
+ * Normalerweise gilt ein Paket erst als vollständig, wenn der mit
+ * turag_feldbus_device_start_receive_timeout() gestartete Timer abläuft.
+ * Ist diese Option auf 1 gesetzt, bestimmt turag_feldbus_device_byte_received()
+ * nach den ersten Datenbytes die erwartete Länge eines an dieses Gerät
+ * gerichteten Pakets und übergibt es direkt nach dem letzten Byte der Checksumme
+ * zur Bearbeitung. Die Pause bis zum Timeout entfällt damit.
+ *
+ * Die Länge reservierter Pakete mit fester Argumentanzahl ist bekannt, die
+ * Länge der Pakete des Geräteprotokolls liefert die mit
+ * turag_feldbus_device_set_frame_length_hint() gesetzte Funktion. Pakete
+ * ohne bekannte Länge, Ping-Anfragen und Broadcasts werden weiterhin
+ * durch den Timeout abgeschlossen.
+ *
+ * Hat mit \ref TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER keine Wirkung.
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_FRAME_LENGTH_HINTS		0
+
+
+/**
+ * turag_feldbus_do_processing() ohne Interrupt-Sperre (optional, Standardwert: 0).
+ *
+ * Empfangene Pakete werden immer ohne Interrupt-Sperre an
+ * turag_feldbus_do_processing() übergeben, ebenso das Neustarten des Empfangs mit
+ * \ref TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER und das Ändern der Busadresse.
+ * Paket-Trace, Laufzeitmessung und Verkehrsstatistik kommen ebenfalls ohne Sperre aus.
+ *
+ * Gesperrt werden die Interrupts nur noch, wenn das Gerät
+ * turag_feldbus_device_goto_sleep() implementiert: Liegt kein Paket vor, wird
+ * zwischen der Prüfung und dem Einschlafen kurz gesperrt, damit kein Paket
+ * unbemerkt fertig wird. Ohne diese Funktion gibt es nichts zu verpassen, weil
+ * der nächste Aufruf das Paket findet.
+ *
+ * Ist diese Option auf 1 gesetzt, entfällt auch diese Sperre, sodass andere
+ * Interrupts (z.B. PWM oder Encoder) durch die Hauptschleife nie verzögert
+ * werden. Ein Paket, das genau vor dem Einschlafen fertig wird, wird dann erst nach
+ * dem nächsten Interrupt bearbeitet.
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_LOCK_FREE_PROCESSING	0
+
+
+/**
+ * Größe des Puffers für verzögerte Antworten (optional, Standardwert: 0).
+ *
+ * Ist der Wert größer als 0, kann der \ref TuragFeldbusPacketProcessor
+ * langwierige Vorgänge (z.B. ADC-Wandlungen oder Flash-Zugriffe) anstoßen,
+ * ohne turag_feldbus_do_processing() zu blockieren: Er holt sich mit
+ * turag_feldbus_device_defer_answer() einen Puffer für die Antwort und gibt
+ * \ref TURAG_FELDBUS_DEFERRED_ANSWER zurück. Die Antwort wird später aus der
+ * Hauptschleife oder einem anderen Task mit turag_feldbus_device_complete_deferred_answer()
+ * fertiggestellt.
+ *
+ * Bis dahin beantwortet das Gerät die Anfrage und jede Wiederholung
+ * derselben Anfrage mit einem leeren Paket, ohne den Packet-Processor aufzurufen.
+ * Der Master wiederholt die Anfrage, bis er die eigentliche Antwort erhält.
+ * Antworten verzögerter Anfragen sollten daher nie leer sein. Andere Pakete
+ * werden in der Zwischenzeit normal bearbeitet.
+ *
+ * Es kann immer nur eine Antwort gleichzeitig verzögert werden. Eine fertige
+ * Antwort, die der Master nicht abholt, belegt den Puffer, bis die nächste
+ * Anfrage verzögert wird.
+ *
+ * Gültige Werte: 0 bis \ref TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - \ref TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE	0
+
+
+/**
+ * Größe des statischen Puffers für Coroutinen-Handler (optional, Standardwert: 0).
+ *
+ * Ist der Wert größer als 0, können Pakete in C++20 von Coroutinen bearbeitet
+ * werden, die mit co_await auf eine Bedingung oder die nächste Pause auf dem Bus
+ * warten, statt turag_feldbus_do_processing() zu blockieren (siehe \ref feldbus-slave-coroutine).
+ * Der Zustand der Coroutine liegt in einem statischen Puffer dieser Größe, da kein
+ * Heap benutzt wird. Wie groß er sein muss, hängt von den lokalen Variablen der
+ * Handler und vom Compiler ab.
+ *
+ * Setzt \ref TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE größer 0 voraus.
+ *
+ * Gültige Werte: 0-65535
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE	0
+
+
+/**
+ * Checksumme erst während des Sendens berechnen (optional, Standardwert: 0).
+ *
+ * Ist diese Option auf 1 gesetzt, berechnet turag_feldbus_device_ready_to_transmit()
+ * die Checksumme der Antwort Byte für Byte und hängt sie nach dem letzten
+ * Datenbyte an. Die Übertragung beginnt damit direkt, nachdem der Paket-Prozessor
+ * zurückgekehrt ist, anstatt erst nach einem Durchlauf über den gesamten Sendepuffer.
+ *
+ * Dafür wird jeder Aufruf des Data-Register-Empty-Interrupts etwas länger.
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_TX_CHECKSUM_IN_ISR		0
+
+
+/**
+ * Blockweise Übertragung (optional, Standardwert: 0).
+ *
+ * Ist diese Option auf 1 gesetzt, werden Pakete nicht mehr Byte für Byte
+ * über Interrupts gesendet und empfangen, sondern als ganzer Block, z.B. per DMA.
+ * Statt turag_feldbus_device_transmit_byte() und der Interrupt-Funktionen
+ * muss der Hardware-Treiber dann turag_feldbus_device_transmit_block() und
+ * turag_feldbus_device_start_block_receive() bereitstellen und 
+ * turag_feldbus_device_block_transmitted() bzw. turag_feldbus_device_block_received()
+ * aufrufen. Das reduziert die Interrupt-Last bei hohen Baudraten erheblich.
+ *
+ * Kann nicht mit \ref TURAG_FELDBUS_DEVICE_CONFIG_RX_CHECKSUM_IN_ISR und
+ * \ref TURAG_FELDBUS_DEVICE_CONFIG_TX_CHECKSUM_IN_ISR kombiniert werden.
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER			0
+
+
+/**
+ * Anzahl eigener reservierter Befehle (optional, Standardwert: 0).
+ *
+ * Legt fest, wie viele Befehls-IDs ab \ref TURAG_FELDBUS_DEVICE_COMMAND_USER_FIRST
+ * mit turag_feldbus_device_register_command() belegt werden können. Jede
+ * ID kostet einen Funktionszeiger RAM.
+ *
+ * Gültige Werte: 0-128
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_USER_COMMAND_COUNT		0
+
+
+/**
+ * Segmentierte Übertragung großer Objekte (optional, Standardwert: 0).
+ *
+ * Ist diese Option auf 1 gesetzt, beantwortet das Gerät
+ * \ref TURAG_FELDBUS_DEVICE_COMMAND_READ_SEGMENTED. Gerätename, Versionsinfo,
+ * der statische Speicher und eigene Objekte (siehe turag_feldbus_device_get_object_size())
+ * können damit unabhängig von \ref TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE
+ * vollständig gelesen werden. Auf eine Anfrage sendet das Gerät ein Fenster aus
+ * mehreren Segmenten, jedes als eigenes Paket. Zwischen den Paketen wartet
+ * turag_feldbus_do_processing() jeweils den mit turag_feldbus_device_start_receive_timeout()
+ * gestarteten Timer ab, damit der Master die Pakete trennen kann.
+ *
+ * Mit \ref TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER gibt es diesen Timer nicht,
+ * dann wird pro Anfrage nur ein Segment gesendet.
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER		0
+
+
+/**
+ * Länge der Warteschlange für Bulk-Schreibzugriffe (optional, Standardwert: 0).
+ *
+ * Ist der Wert größer 0, beantwortet das Gerät
+ * \ref TURAG_FELDBUS_DEVICE_COMMAND_BULK_WRITE. Der Master kann dann mehrere
+ * Schreibpakete für den statischen Speicher direkt hintereinander senden.
+ * Die Pakete werden im RAM zwischengespeichert und von turag_feldbus_do_processing()
+ * programmiert, während weitere Pakete empfangen werden. Jeder Eintrag belegt
+ * etwa \ref TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE Bytes RAM.
+ *
+ * Die Pakete werden mit turag_feldbus_device_start_write_to_static_storage() und
+ * turag_feldbus_device_poll_write_to_static_storage() programmiert. Solange Pakete
+ * warten, werden Lese-, Schreib- und Prüfsummenanfragen an den statischen Speicher mit
+ * \ref TURAG_FELDBUS_DEVICE_STORAGE_BUSY beantwortet.
+ *
+ * Damit Pakete auch während des Programmierens empfangen werden, sollte
+ * \ref TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT größer 1 sein.
+ *
+ * Gültige Werte: 0-255
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH		0
+
+
+/**
+ * Asynchrones Schreiben des statischen Speichers (optional, Standardwert: 0).
+ *
+ * Ist diese Option auf 1 gesetzt, wird
+ * \ref TURAG_FELDBUS_DEVICE_COMMAND_WRITE_TO_STATIC_STORAGE sofort beantwortet
+ * und die Daten erst danach von turag_feldbus_do_processing() geschrieben.
+ * Den Abschluss fragt der Master mit
+ * \ref TURAG_FELDBUS_DEVICE_COMMAND_STATIC_STORAGE_STATUS ab.
+ *
+ * Damit auch die Hauptschleife nicht blockiert, sollten
+ * turag_feldbus_device_start_write_to_static_storage() und
+ * turag_feldbus_device_poll_write_to_static_storage() implementiert werden.
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE		0
+
+
+/**
+ * Prüfsummen über den statischen Speicher (optional, Standardwert: 0).
+ *
+ * Ist diese Option auf 1 gesetzt, beantwortet das Gerät
+ * \ref TURAG_FELDBUS_DEVICE_COMMAND_HASH_STATIC_STORAGE. Der Master kann
+ * damit den Inhalt des Speichers prüfen, ohne ihn auszulesen. Der Speicher
+ * wird dazu in Stücken von \ref TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE Bytes
+ * gelesen. Belegt zusätzlich die Tabelle der CRC16-Prüfsumme im Flash.
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH			0
+
+/**
+ * Maximale Länge eines Bereichs für
+ * \ref TURAG_FELDBUS_DEVICE_COMMAND_HASH_STATIC_STORAGE (optional, Standardwert: 1024).
+ *
+ * Die Prüfsumme wird vollständig in turag_feldbus_do_processing() berechnet,
+ * das so lange keine weiteren Pakete bearbeitet. Längere Bereiche werden mit
+ * \ref TURAG_FELDBUS_DEVICE_HASH_TOO_LONG abgelehnt und müssen vom Master
+ * in mehreren Anfragen geprüft werden. Der Wert sollte so gewählt werden,
+ * dass die Berechnung kürzer ist als das Timeout des Masters.
+ *
+ * Gültige Werte: 1-65535
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH_MAX_LENGTH	1024
+
+
+/**
+ * Busadresse dauerhaft speichern (optional, Standardwert: 0).
+ *
+ * Ist diese Option auf 1 gesetzt, wird eine per Broadcast zugewiesene oder
+ * zurückgesetzte Adresse mit turag_feldbus_device_store_address() gespeichert
+ * und von turag_feldbus_device_init() wiederhergestellt. Nach einem Reset
+ * muss der Master das Gerät dann nicht erneut über die UUID adressieren.
+ * Die wiederhergestellte Adresse hat Vorrang vor der an
+ * turag_feldbus_device_init() übergebenen.
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS		0
+
+/**
+ * Position der Busadresse im statischen Speicher (optional, Standardwert: 0).
+ *
+ * Die Adresse belegt 2 * \ref TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH Bytes.
+ * Der Wert muss ein Vielfaches der Seitengröße sein. Wird nicht benutzt, wenn
+ * turag_feldbus_device_load_address() und turag_feldbus_device_store_address()
+ * überschrieben werden.
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS_OFFSET	0
+
+
+/**
+ * Laufzeitmessung der Paketverarbeitung (optional, Standardwert: 0).
+ *
+ * Ist diese Option auf 1 gesetzt, misst das Gerät mit
+ * turag_feldbus_device_get_cycle_count() die Dauer jeder Stufe der
+ * Verarbeitung (Warten auf turag_feldbus_do_processing(), Prüfsumme,
+ * Bearbeitung, Senden) und führt dafür Minimum, Maximum und ein Histogramm.
+ * Der Master liest die Werte mit \ref TURAG_FELDBUS_DEVICE_COMMAND_GET_PROFILE
+ * aus und setzt sie mit \ref TURAG_FELDBUS_DEVICE_COMMAND_RESET_PROFILE zurück.
+ *
+ * Alle Werte werden von der Hauptschleife geführt. Die Dauer einer
+ * Übertragung übernimmt turag_feldbus_do_processing() erst bei seinem
+ * nächsten Aufruf vom Sende-Interrupt.
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_PROFILING				0
+
+/**
+ * Anzahl der Histogramm-Klassen je Stufe (optional, Standardwert: 8).
+ *
+ * Belegt 2 Bytes RAM je Klasse und Stufe. Die Antwort auf
+ * \ref TURAG_FELDBUS_DEVICE_COMMAND_GET_PROFILE ist 8 + 2 * Anzahl Bytes lang
+ * und muss in \ref TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE passen.
+ *
+ * Gültige Werte: 1-32
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKETS		8
+
+/**
+ * Breite der ersten Histogramm-Klasse als Zweierpotenz (optional, Standardwert: 6).
+ *
+ * Klasse 0 zählt Dauern unter 2^Wert Takten, jede weitere Klasse
+ * deckt den doppelten Bereich der vorherigen ab. Die letzte Klasse zählt
+ * alle längeren Dauern.
+ *
+ * Gültige Werte: 0-31
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKET_SHIFT	6
+
+
+/**
+ * Verkehrsstatistik (optional, Standardwert: 0).
+ *
+ * Ist diese Option auf 1 gesetzt, zählt das Gerät empfangene, gesendete und
+ * an andere Geräte gerichtete Bytes sowie die Pakete je reserviertem Befehl,
+ * je Befehl des Geräteprotokolls und die Broadcasts. Der Master liest die Werte
+ * mit \ref TURAG_FELDBUS_DEVICE_COMMAND_GET_STATISTICS aus,
+ * \ref TURAG_FELDBUS_DEVICE_COMMAND_RESET_PACKAGE_COUNT setzt sie zurück.
+ *
+ * Das Zählen der Bytes verlängert den Empfangs-Interrupt geringfügig.
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS				0
+
+/**
+ * Anzahl der gezählten Befehle des Geräteprotokolls (optional, Standardwert: 16).
+ *
+ * Gezählt wird nach dem ersten Datenbyte der Pakete. Befehle ab diesem Wert
+ * werden gemeinsam gezählt. Belegt 2 Bytes RAM je Befehl.
+ *
+ * Gültige Werte: 1-255
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS_COMMANDS		16
+
+
+/**
+ * Länge des Paket-Traces (optional, Standardwert: 0).
+ *
+ * Ist dieser Wert größer als 0, zeichnet das Gerät die Ereignisse der
+ * Paketverarbeitung auf: empfangene, verlorene, zu lange und
+ * fehlerhafte Pakete sowie die Antworten darauf, jeweils mit
+ * Zeitstempel, Länge und den ersten Bytes. Der Master liest sie mit
+ * \ref TURAG_FELDBUS_DEVICE_COMMAND_READ_TRACE aus. Pakete an andere
+ * Geräte werden nicht aufgezeichnet.
+ *
+ * Ereignisse aus Interrupts und aus der Hauptschleife landen in zwei
+ * getrennten Ringen mit je dieser Länge, sodass dafür keine Interrupts
+ * gesperrt werden. Ist ein Ring voll, werden neue Ereignisse verworfen
+ * und gezählt, bis der Master den Trace ausliest.
+ *
+ * Belegt 17 Bytes RAM je Eintrag. Das Aufzeichnen kostet nur wenige
+ * Takte je Paket und kann daher auch im Betrieb aktiviert bleiben.
+ *
+ * Gültige Werte: 0-255
+ */
+#define TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH			0
+
+
 
 #endif /* FELDBUS_CONFIG_H_ */
  
@@ -36,6 +36,13 @@
 # endif
 #endif
 
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_LOG_SIZE
+# define TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_LOG_SIZE 128
+#endif
+#if (TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_LOG_SIZE<8) || (TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_LOG_SIZE>255)
+# error TURAG_FELDBUS_DEVICE_CONFIG_DEBUG_LOG_SIZE must be within the range of 8-255
+#endif
+
 #ifndef TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY
 # error TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY must be defined
 #else
@@ -44,6 +51,128 @@
 # endif
 #endif
 
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT
+# define TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT 1
+#else
+# if (TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT<1) || (TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT>255)
+#  error TURAG_FELDBUS_DEVICE_CONFIG_RX_BUFFER_COUNT must be within the range of 1-255
+# endif
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_RX_CHECKSUM_IN_ISR
+# define TURAG_FELDBUS_DEVICE_CONFIG_RX_CHECKSUM_IN_ISR 0
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_RX_ADDRESS_FILTER
+# define TURAG_FELDBUS_DEVICE_CONFIG_RX_ADDRESS_FILTER 0
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_TX_CHECKSUM_IN_ISR
+# define TURAG_FELDBUS_DEVICE_CONFIG_TX_CHECKSUM_IN_ISR 0
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_USER_COMMAND_COUNT
+# define TURAG_FELDBUS_DEVICE_CONFIG_USER_COMMAND_COUNT 0
+#else
+# if (TURAG_FELDBUS_DEVICE_CONFIG_USER_COMMAND_COUNT<0) || (TURAG_FELDBUS_DEVICE_CONFIG_USER_COMMAND_COUNT>128)
+#  error TURAG_FELDBUS_DEVICE_CONFIG_USER_COMMAND_COUNT must be within the range of 0-128
+# endif
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER
+# define TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER 0
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH
+# define TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH 0
+#else
+# if (TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH<0) || (TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH>255)
+#  error TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH must be within the range of 0-255
+# endif
+# if (TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH>0) && (TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE<=7)
+#  error TURAG_FELDBUS_DEVICE_CONFIG_BULK_WRITE_QUEUE_LENGTH requires TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE to be greater than 7
+# endif
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE
+# define TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE 0
+#else
+# if TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE && (TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE<=6)
+#  error TURAG_FELDBUS_DEVICE_CONFIG_ASYNC_STORAGE_WRITE requires TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE to be greater than 6
+# endif
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH
+# define TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH 0
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH_MAX_LENGTH
+# define TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH_MAX_LENGTH 1024
+#endif
+#if (TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH_MAX_LENGTH<1) || (TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH_MAX_LENGTH>65535)
+# error TURAG_FELDBUS_DEVICE_CONFIG_STORAGE_HASH_MAX_LENGTH must be within the range of 1-65535
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS
+# define TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS 0
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS_OFFSET
+# define TURAG_FELDBUS_DEVICE_CONFIG_PERSISTENT_ADDRESS_OFFSET 0
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+# define TURAG_FELDBUS_DEVICE_CONFIG_PROFILING 0
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKETS
+# define TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKETS 8
+#endif
+#if (TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKETS<1) || (TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKETS>32)
+# error TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKETS must be within the range of 1-32
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKET_SHIFT
+# define TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKET_SHIFT 6
+#endif
+#if (TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKET_SHIFT<0) || (TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKET_SHIFT>31)
+# error TURAG_FELDBUS_DEVICE_CONFIG_PROFILING_BUCKET_SHIFT must be within the range of 0-31
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS
+# define TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS 0
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS_COMMANDS
+# define TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS_COMMANDS 16
+#endif
+#if (TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS_COMMANDS<1) || (TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS_COMMANDS>255)
+# error TURAG_FELDBUS_DEVICE_CONFIG_STATISTICS_COMMANDS must be within the range of 1-255
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH
+# define TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH 0
+#endif
+#if (TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH<0) || (TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH>255)
+# error TURAG_FELDBUS_DEVICE_CONFIG_TRACE_LENGTH must be within the range of 0-255
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_LOCK_FREE_PROCESSING
+# define TURAG_FELDBUS_DEVICE_CONFIG_LOCK_FREE_PROCESSING 0
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_FRAME_LENGTH_HINTS
+# define TURAG_FELDBUS_DEVICE_CONFIG_FRAME_LENGTH_HINTS 0
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER
+# define TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER 0
+#else
+# if TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER && (TURAG_FELDBUS_DEVICE_CONFIG_RX_CHECKSUM_IN_ISR || TURAG_FELDBUS_DEVICE_CONFIG_TX_CHECKSUM_IN_ISR)
+#  error TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER cannot be combined with TURAG_FELDBUS_DEVICE_CONFIG_RX_CHECKSUM_IN_ISR or TURAG_FELDBUS_DEVICE_CONFIG_TX_CHECKSUM_IN_ISR
+# endif
+#endif
+
 
 #if TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE > 65535
 # error buffer sizes greater than 65535 are no longer supported.
@@ -55,7 +184,42 @@
 # define TURAG_FELDBUS_NO_ANSWER 0xff
 #endif
 
-#define TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH 1
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH
+# define TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH 1
+#else
+# if (TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH != 1) && (TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH != 2)
+#  error TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH must be 1 or 2
+# endif
+#endif
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH == 2
+    typedef uint16_t FeldbusAddress_t;
+#else
+    typedef uint8_t FeldbusAddress_t;
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE
+# define TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE 0
+#endif
+#if (TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE<0) || (TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE>TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE-TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH)
+# error TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE must be within the range of 0-(TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE-TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH)
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE > 0
+# if TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE == 255 || TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE == 65535
+#  error TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE requires a buffer size other than 255 or 65535
+# endif
+# define TURAG_FELDBUS_DEFERRED_ANSWER ((FeldbusSize_t)(TURAG_FELDBUS_NO_ANSWER - 1))
+#endif
+
+#ifndef TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE
+# define TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE 0
+#endif
+#if (TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE<0) || (TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE>65535)
+# error TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE must be within the range of 0-65535
+#endif
+#if TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE > 0 && TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE == 0
+# error TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE requires TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE
+#endif
 
 
 #endif // (!defined(__DOXYGEN__))
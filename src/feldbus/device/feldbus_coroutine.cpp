@@ -0,0 +1,89 @@
+#include "feldbus_coroutine.h"
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE > 0
+
+#include <string.h>
+
+
+// Only one answer can be deferred, so only one handler can be suspended
+// at a time and a single frame is all we need.
+alignas(__BIGGEST_ALIGNMENT__) static uint8_t coroutine_frame[TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE];
+static bool coroutine_frame_used = false;
+
+// the suspended handler and the condition it waits for
+static std::coroutine_handle<TuragFeldbusCoroutine::promise_type> waiting_handler;
+static bool (*waiting_ready)(void* context);
+static void* waiting_context;
+
+
+void* TuragFeldbusCoroutine::promise_type::operator new(size_t size) noexcept {
+	if (coroutine_frame_used || size > sizeof(coroutine_frame)) {
+		return 0;
+	}
+	coroutine_frame_used = true;
+	return coroutine_frame;
+}
+
+void TuragFeldbusCoroutine::promise_type::operator delete(void*, size_t) noexcept {
+	coroutine_frame_used = false;
+}
+
+
+FeldbusSize_t turag_feldbus_device_start_coroutine(TuragFeldbusCoroutineProcessor handler,
+		const uint8_t* message, FeldbusSize_t message_length, uint8_t* response)
+{
+	// The handler writes into the buffer of the deferred answer, so it
+	// does not matter whether it finishes right away or not.
+	uint8_t* answer = turag_feldbus_device_defer_answer();
+	if (!answer) {
+		// another handler is still waiting, the master has to retry
+		return TURAG_FELDBUS_DEFERRED_ANSWER;
+	}
+
+	TuragFeldbusCoroutine coroutine = handler(message, message_length, answer);
+	if (!coroutine.handle) {
+		print_text("coroutine frame too small\n");
+		turag_feldbus_device_complete_deferred_answer(TURAG_FELDBUS_NO_ANSWER);
+		return TURAG_FELDBUS_NO_ANSWER;
+	}
+
+	if (!coroutine.handle.done()) {
+		// continued by turag_feldbus_do_processing()
+		waiting_handler = coroutine.handle;
+		coroutine.handle = nullptr;
+		return TURAG_FELDBUS_DEFERRED_ANSWER;
+	}
+
+	// finished without waiting, the answer goes out right away
+	FeldbusSize_t length = coroutine.handle.promise().answer_length;
+	if (length != TURAG_FELDBUS_NO_ANSWER) {
+		memcpy(response, answer, length);
+	}
+	turag_feldbus_device_complete_deferred_answer(TURAG_FELDBUS_NO_ANSWER);
+	return length;
+}
+
+
+void turag_feldbus_device_coroutine_wait(bool (*ready)(void* context), void* context) {
+	waiting_ready = ready;
+	waiting_context = context;
+}
+
+
+extern "C" bool turag_feldbus_device_coroutine_ready(void) {
+	return waiting_handler && waiting_ready(waiting_context);
+}
+
+extern "C" void turag_feldbus_device_resume_coroutine(void) {
+	waiting_handler.resume();
+	if (!waiting_handler.done()) {
+		return;
+	}
+
+	FeldbusSize_t length = waiting_handler.promise().answer_length;
+	waiting_handler.destroy();
+	waiting_handler = nullptr;
+	turag_feldbus_device_complete_deferred_answer(length);
+}
+
+#endif
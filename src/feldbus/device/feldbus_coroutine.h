@@ -0,0 +1,214 @@
+/**
+ *  @brief		Packet processing with C++20 coroutines
+ *  @file		feldbus_coroutine.h
+ *  @ingroup	feldbus-slave-coroutine
+ */
+
+/**
+ *  @defgroup 	feldbus-slave-coroutine Coroutinen-Handler
+ *  @ingroup	feldbus-slave
+ *
+ * Dieses Modul ist eine C++20-Alternative zum \ref TuragFeldbusPacketProcessor
+ * für Befehle, die aus mehreren langwierigen Schritten bestehen. Statt dafür
+ * einen Zustandsautomaten zu schreiben oder die Hauptschleife zu blockieren,
+ * wartet der Handler mit co_await und turag_feldbus_do_processing() bearbeitet
+ * in der Zwischenzeit weitere Pakete:
+ *
+ * \code
+ * static TuragFeldbusCoroutine process_package(const uint8_t* message, FeldbusSize_t length, uint8_t* response) {
+ *     if (message[0] != MEASURE) {
+ *         co_return TURAG_FELDBUS_NO_ANSWER;
+ *     }
+ *     adc_start();
+ *     co_await turag_feldbus_device_wait_until([] { return adc_done(); });
+ *     uint16_t value = adc_read();
+ *     memcpy(response, &value, sizeof(value));
+ *     co_return sizeof(value);
+ * }
+ *
+ * turag_feldbus_device_init(address, uuid, "ADC", "v1.0", protocol, type,
+ *     turag_feldbus_device_coroutine_processor<process_package>, 0);
+ * \endcode
+ *
+ * Der Handler läuft bis zum ersten co_await im \ref TuragFeldbusPacketProcessor.
+ * Wartet er, wird die Antwort mit turag_feldbus_device_defer_answer() verzögert
+ * und der Master wiederholt die Anfrage, bis der Handler mit co_return fertig
+ * ist. Fortgesetzt wird der Handler von turag_feldbus_do_processing(), wenn
+ * kein Paket vorliegt.
+ *
+ * Zu beachten ist:
+ * - message ist nur bis zum ersten co_await gültig. Benötigte Argumente
+ *   müssen vorher in lokale Variablen kopiert werden.
+ * - response zeigt auf den Puffer für verzögerte Antworten. Antworten sind
+ *   daher auf \ref TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE Bytes begrenzt.
+ * - Es kann nur ein Handler gleichzeitig warten. Währenddessen werden weitere
+ *   Pakete, die einen Handler starten würden, mit einem leeren Paket beantwortet.
+ * - Der Zustand des Handlers liegt in einem statischen Puffer mit
+ *   \ref TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE Bytes. Passt er nicht
+ *   hinein, wird das Paket nicht beantwortet.
+ * - Gibt der Handler nach einem co_await \ref TURAG_FELDBUS_NO_ANSWER zurück, wird
+ *   die Anfrage verworfen und ihre nächste Wiederholung startet den Handler erneut.
+ *   Fehler sollten deshalb in der Antwort gemeldet werden.
+ *
+ * \pre Nur verfügbar, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE größer 0 ist.
+ * Erfordert C++20.
+ */
+#ifndef TURAG_FELDBUS_SLAVE_FELDBUS_COROUTINE_H_
+#define TURAG_FELDBUS_SLAVE_FELDBUS_COROUTINE_H_
+
+#include <feldbus/device/feldbus_base.h>
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE > 0 || defined(__DOXYGEN__)
+
+#if !defined(__cpp_impl_coroutine) && !defined(__DOXYGEN__)
+# error TURAG_FELDBUS_DEVICE_CONFIG_COROUTINE_FRAME_SIZE requires C++20 coroutines
+#endif
+
+#include <coroutine>
+#include <stddef.h>
+
+
+/**
+ * Rückgabetyp der Coroutinen-Handler.
+ *
+ * Der Handler gibt mit co_return die Länge der Antwort oder
+ * \ref TURAG_FELDBUS_NO_ANSWER zurück, wie ein \ref TuragFeldbusPacketProcessor.
+ */
+class TuragFeldbusCoroutine {
+public:
+	/// \cond INTERNAL
+	struct promise_type {
+		FeldbusSize_t answer_length = TURAG_FELDBUS_NO_ANSWER;
+
+		TuragFeldbusCoroutine get_return_object() noexcept {
+			return TuragFeldbusCoroutine(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+		// the frame did not fit into the static buffer
+		static TuragFeldbusCoroutine get_return_object_on_allocation_failure() noexcept {
+			return TuragFeldbusCoroutine(nullptr);
+		}
+		// the handler runs until the first co_await within the packet processor
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		// the frame stays alive until the answer is taken
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_value(FeldbusSize_t length) noexcept { answer_length = length; }
+		void unhandled_exception() noexcept { answer_length = TURAG_FELDBUS_NO_ANSWER; }
+
+		// frames are taken from a static buffer, there is no heap
+		static void* operator new(size_t size) noexcept;
+		static void operator delete(void* frame, size_t size) noexcept;
+	};
+
+	explicit TuragFeldbusCoroutine(std::coroutine_handle<promise_type> handle) : handle(handle) { }
+	TuragFeldbusCoroutine(TuragFeldbusCoroutine&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+	TuragFeldbusCoroutine(const TuragFeldbusCoroutine&) = delete;
+	TuragFeldbusCoroutine& operator=(const TuragFeldbusCoroutine&) = delete;
+	~TuragFeldbusCoroutine() {
+		if (handle) {
+			handle.destroy();
+		}
+	}
+
+	std::coroutine_handle<promise_type> handle;
+	/// \endcond
+};
+
+/**
+ * @param[in] message			Buffer holding the received data, only valid until the first co_await
+ * @param[in] message_length	Size of received data
+ * @param[out] response			Buffer for the response data with
+ * \ref TURAG_FELDBUS_DEVICE_CONFIG_DEFERRED_ANSWER_SIZE bytes
+ *
+ * Coroutinen-Handler, siehe \ref feldbus-slave-coroutine.
+ *
+ * \note Diese Funktion wird stets im main-Kontext aufgerufen und fortgesetzt.
+ */
+typedef TuragFeldbusCoroutine (*TuragFeldbusCoroutineProcessor)(const uint8_t* message, FeldbusSize_t message_length, uint8_t* response);
+
+
+/**
+ * Startet einen Coroutinen-Handler für das Paket, das gerade bearbeitet wird.
+ * @return			Rückgabewert für den \ref TuragFeldbusPacketProcessor
+ *
+ * Muss im \ref TuragFeldbusPacketProcessor aufgerufen werden und ermöglicht es,
+ * nur einzelne Befehle mit Coroutinen zu bearbeiten:
+ * \code
+ * case MEASURE:
+ *     return turag_feldbus_device_start_coroutine(measure, message, length, response);
+ * \endcode
+ */
+FeldbusSize_t turag_feldbus_device_start_coroutine(TuragFeldbusCoroutineProcessor handler,
+		const uint8_t* message, FeldbusSize_t message_length, uint8_t* response);
+
+/**
+ * \ref TuragFeldbusPacketProcessor, der alle Pakete an den Coroutinen-Handler
+ * Handler (Template-Argument) weitergibt.
+ */
+template<TuragFeldbusCoroutineProcessor Handler>
+FeldbusSize_t turag_feldbus_device_coroutine_processor(const uint8_t* message, FeldbusSize_t message_length, uint8_t* response) {
+	return turag_feldbus_device_start_coroutine(Handler, message, message_length, response);
+}
+
+
+/// \cond INTERNAL
+// lets the suspended handler continue once ready(context) returns true
+void turag_feldbus_device_coroutine_wait(bool (*ready)(void* context), void* context);
+/// \endcond
+
+/**
+ * Awaitable, siehe turag_feldbus_device_wait_until().
+ */
+template<typename Predicate>
+struct TuragFeldbusWaitUntil {
+	/// \cond INTERNAL
+	Predicate predicate;
+
+	bool await_ready() { return predicate(); }
+	void await_suspend(std::coroutine_handle<>) {
+		// the awaitable is part of the frame and stays valid while the handler waits
+		turag_feldbus_device_coroutine_wait([](void* context) {
+			return (bool)static_cast<TuragFeldbusWaitUntil*>(context)->predicate();
+		}, this);
+	}
+	void await_resume() noexcept { }
+	/// \endcond
+};
+
+/**
+ * Wartet, bis predicate true liefert.
+ * @param predicate		Funktion oder Lambda ohne Argumente
+ *
+ * predicate wird von turag_feldbus_do_processing() geprüft, solange kein Paket
+ * vorliegt, und darf daher nicht blockieren. Wird die Bedingung in einem Interrupt
+ * erfüllt, wird der Handler nach turag_feldbus_device_goto_sleep() fortgesetzt.
+ */
+template<typename Predicate>
+TuragFeldbusWaitUntil<Predicate> turag_feldbus_device_wait_until(Predicate predicate) {
+	return TuragFeldbusWaitUntil<Predicate> { predicate };
+}
+
+/**
+ * Awaitable, siehe turag_feldbus_device_next_idle().
+ */
+struct TuragFeldbusNextIdle {
+	/// \cond INTERNAL
+	bool await_ready() noexcept { return false; }
+	void await_suspend(std::coroutine_handle<>) {
+		turag_feldbus_device_coroutine_wait([](void*) { return true; }, 0);
+	}
+	void await_resume() noexcept { }
+	/// \endcond
+};
+
+/**
+ * Wartet auf den nächsten Aufruf von turag_feldbus_do_processing(), bei dem
+ * kein Paket vorliegt. Damit lassen sich lange Berechnungen in Schritte
+ * aufteilen, zwischen denen andere Pakete beantwortet werden.
+ */
+inline TuragFeldbusNextIdle turag_feldbus_device_next_idle(void) {
+	return TuragFeldbusNextIdle();
+}
+
+#endif
+
+#endif // TURAG_FELDBUS_SLAVE_FELDBUS_COROUTINE_H_
@@ -0,0 +1,241 @@
+#include "feldbus_kvstore.h"
+#include <string.h>
+
+
+
+#ifndef TURAG_FELDBUS_KVSTORE_KEY_COUNT
+# define TURAG_FELDBUS_KVSTORE_KEY_COUNT 32
+#endif
+#if (TURAG_FELDBUS_KVSTORE_KEY_COUNT<1) || (TURAG_FELDBUS_KVSTORE_KEY_COUNT>255)
+# error TURAG_FELDBUS_KVSTORE_KEY_COUNT must be within the range of 1-255
+#endif
+
+#ifndef TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH
+# define TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH 16
+#endif
+#if (TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH<1) || (TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH>252)
+# error TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH must be within the range of 1-252
+#endif
+
+
+// Each half starts with a header: 'T', 'K', generation (uint16_t), crc8.
+// The half with the newer generation is active. The header is written
+// last when a half is compacted, so a half is only used once it is complete.
+#define HEADER_SIZE			5
+#define HEADER_MAGIC_0		'T'
+#define HEADER_MAGIC_1		'K'
+
+// The records follow the header, each one starting on a page boundary:
+// key, length, value, crc8 over key, length and value. A length of 0
+// removes the key. The log ends with an END byte. New records are appended
+// by writing the END byte behind the new record first and then the record
+// itself over the old END byte.
+#define RECORD_OVERHEAD		3
+#define END					0xff
+
+
+static uint32_t area_offset;
+static uint16_t half_size;
+static uint16_t page_size;
+static uint8_t active_half;
+static uint16_t generation;
+// position of the END byte in the active half
+static uint16_t append_position;
+// position of the latest record of each key in the active half, 0 if the key has no value
+static uint16_t key_index[TURAG_FELDBUS_KVSTORE_KEY_COUNT];
+
+
+static uint16_t pad(uint16_t size) {
+	return (size + page_size - 1) / page_size * page_size;
+}
+
+static bool storage_read(uint8_t half, uint16_t position, void* buffer, uint16_t size) {
+	return turag_feldbus_device_read_from_static_storage(area_offset + (uint32_t)half * half_size + position, size, (uint8_t*)buffer) == 0;
+}
+
+static bool storage_write(uint8_t half, uint16_t position, const void* data, uint16_t size) {
+	return turag_feldbus_device_write_to_static_storage(area_offset + (uint32_t)half * half_size + position, (const uint8_t*)data, size) == 0;
+}
+
+static bool write_end(uint8_t half, uint16_t position) {
+	static const uint8_t end = END;
+	return storage_write(half, position, &end, 1);
+}
+
+static bool read_header(uint8_t half, uint16_t* generation_) {
+	uint8_t header[HEADER_SIZE];
+	if (!storage_read(half, 0, header, HEADER_SIZE) ||
+			header[0] != HEADER_MAGIC_0 || header[1] != HEADER_MAGIC_1 ||
+			header[4] != turag_crc8_calculate(header, HEADER_SIZE - 1)) {
+		return false;
+	}
+	*generation_ = header[2] | (header[3] << 8);
+	return true;
+}
+
+static bool write_header(uint8_t half, uint16_t generation_) {
+	uint8_t header[HEADER_SIZE] = { HEADER_MAGIC_0, HEADER_MAGIC_1, generation_ & 0xff, generation_ >> 8, 0 };
+	header[4] = turag_crc8_calculate(header, HEADER_SIZE - 1);
+	return storage_write(half, 0, header, HEADER_SIZE);
+}
+
+// reads the record at position and returns its total size
+// or 0 if there is no valid record
+static uint16_t read_record(uint8_t half, uint16_t position, uint8_t* record) {
+	if (position + RECORD_OVERHEAD > half_size || !storage_read(half, position, record, 2)) {
+		return 0;
+	}
+	uint8_t key = record[0];
+	uint8_t length = record[1];
+	uint16_t size = RECORD_OVERHEAD + length;
+
+	if (key == END || key >= TURAG_FELDBUS_KVSTORE_KEY_COUNT || length > TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH ||
+			position + size > half_size || !storage_read(half, position + 2, record + 2, size - 2) ||
+			record[size - 1] != turag_crc8_calculate(record, size - 1)) {
+		// end of log or interrupted write
+		return 0;
+	}
+	return size;
+}
+
+static void scan(void) {
+	uint8_t record[RECORD_OVERHEAD + TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH];
+	uint16_t position = pad(HEADER_SIZE);
+	uint16_t size;
+
+	memset(key_index, 0, sizeof(key_index));
+	while ((size = read_record(active_half, position, record)) != 0) {
+		key_index[record[0]] = record[1] ? position : 0;
+		position += pad(size);
+	}
+	append_position = position;
+}
+
+// copies the latest values into the other half and makes it active
+static bool compact(void) {
+	uint8_t record[RECORD_OVERHEAD + TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH];
+	uint8_t target = active_half ^ 1;
+	uint16_t position = pad(HEADER_SIZE);
+
+	for (uint8_t key = 0; key < TURAG_FELDBUS_KVSTORE_KEY_COUNT; ++key) {
+		if (!key_index[key]) {
+			continue;
+		}
+		uint16_t size = read_record(active_half, key_index[key], record);
+		if (!size || !storage_write(target, position, record, size)) {
+			scan();
+			return false;
+		}
+		key_index[key] = position;
+		position += pad(size);
+	}
+
+	if (!write_end(target, position) || !write_header(target, generation + 1)) {
+		scan();
+		return false;
+	}
+	active_half = target;
+	++generation;
+	append_position = position;
+	return true;
+}
+
+static bool append(uint8_t key, const void* value, uint8_t length) {
+	uint8_t record[RECORD_OVERHEAD + TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH];
+	uint16_t size = RECORD_OVERHEAD + length;
+
+	if (append_position + pad(size) + 1 > half_size) {
+		if (!compact() || append_position + pad(size) + 1 > half_size) {
+			return false;
+		}
+	}
+
+	record[0] = key;
+	record[1] = length;
+	if (length) {
+		memcpy(record + 2, value, length);
+	}
+	record[size - 1] = turag_crc8_calculate(record, size - 1);
+
+	// until the record is complete the old END byte terminates the log
+	if (!write_end(active_half, append_position + pad(size)) ||
+			!storage_write(active_half, append_position, record, size)) {
+		return false;
+	}
+	key_index[key] = length ? append_position : 0;
+	append_position += pad(size);
+	return true;
+}
+
+
+bool turag_feldbus_kvstore_init(uint32_t offset, uint32_t size) {
+	page_size = turag_feldbus_device_get_static_storage_page_size();
+	if (page_size == 0) {
+		page_size = 1;
+	}
+	if (offset % page_size != 0 || size / 2 > 65535) {
+		return false;
+	}
+	area_offset = offset;
+	// a compacted half has to hold the longest value of every key and an END byte,
+	// otherwise updates fail for good once the half is full
+	uint32_t needed = pad(HEADER_SIZE) + (uint32_t)TURAG_FELDBUS_KVSTORE_KEY_COUNT * pad(RECORD_OVERHEAD + TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH) + 1;
+	half_size = size / 2 / page_size * page_size;
+	if (half_size < needed) {
+		return false;
+	}
+
+	uint16_t generation0, generation1;
+	bool valid0 = read_header(0, &generation0);
+	bool valid1 = read_header(1, &generation1);
+
+	if (valid0 && valid1) {
+		// the generation may overflow
+		active_half = (int16_t)(generation1 - generation0) > 0 ? 1 : 0;
+		generation = active_half ? generation1 : generation0;
+	} else if (valid0 || valid1) {
+		active_half = valid1 ? 1 : 0;
+		generation = valid1 ? generation1 : generation0;
+	} else {
+		active_half = 0;
+		generation = 0;
+		if (!write_end(0, pad(HEADER_SIZE)) || !write_header(0, 0)) {
+			return false;
+		}
+	}
+
+	scan();
+	return true;
+}
+
+uint8_t turag_feldbus_kvstore_length(uint8_t key) {
+	uint8_t length;
+	if (key >= TURAG_FELDBUS_KVSTORE_KEY_COUNT || !key_index[key] || !storage_read(active_half, key_index[key] + 1, &length, 1)) {
+		return 0;
+	}
+	return length;
+}
+
+bool turag_feldbus_kvstore_get(uint8_t key, void* value, uint8_t length) {
+	if (turag_feldbus_kvstore_length(key) != length || length == 0) {
+		return false;
+	}
+	return storage_read(active_half, key_index[key] + 2, value, length);
+}
+
+bool turag_feldbus_kvstore_set(uint8_t key, const void* value, uint8_t length) {
+	if (key >= TURAG_FELDBUS_KVSTORE_KEY_COUNT || length == 0 || length > TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH) {
+		return false;
+	}
+	return append(key, value, length);
+}
+
+bool turag_feldbus_kvstore_erase(uint8_t key) {
+	if (key >= TURAG_FELDBUS_KVSTORE_KEY_COUNT) {
+		return false;
+	}
+	if (!key_index[key]) {
+		return true;
+	}
+	return append(key, 0, 0);
+}
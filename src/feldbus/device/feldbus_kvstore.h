@@ -0,0 +1,109 @@
+/**
+ *  @brief		Log-structured key-value store on top of the static storage
+ *  @file		feldbus_kvstore.h
+ *  @ingroup	feldbus-slave-kvstore
+ */
+
+/**
+ *  @defgroup 	feldbus-slave-kvstore Key-Value-Speicher
+ *  @ingroup	feldbus-slave
+ *
+ * Dieses Modul speichert Parameter des Gerätes als Schlüssel-Wert-Paare
+ * im statischen Speicher, auf den es ausschließlich über
+ * turag_feldbus_device_read_from_static_storage(),
+ * turag_feldbus_device_write_to_static_storage() und
+ * turag_feldbus_device_get_static_storage_page_size() zugreift.
+ *
+ * Der verwendete Bereich wird in zwei Hälften geteilt, von denen immer
+ * eine aktiv ist. Jede Änderung wird als neuer Eintrag an das Ende der aktiven
+ * Hälfte angehängt, statt den alten Wert zu überschreiben. Ist die Hälfte voll,
+ * werden die aktuellen Werte in die andere Hälfte kopiert, die danach aktiv ist.
+ * Dadurch verteilen sich die Schreibzugriffe gleichmäßig über den ganzen Bereich.
+ *
+ * Beim Start baut turag_feldbus_kvstore_init() einen Index im RAM auf, sodass
+ * jeder Zugriff ohne Suche auskommt. Wird die Versorgung während eines
+ * Schreibzugriffs unterbrochen, bleibt der vorherige Wert erhalten.
+ *
+ * Die Einträge beginnen jeweils an einer Seitengrenze. Das Modul eignet sich
+ * deshalb vor allem für Speicher mit kleinen Seiten wie EEPROM.
+ *
+ * Für Tests auf dem Host kann der statische Speicher mit
+ * turag_feldbus_sim_storage_open() durch eine Datei ersetzt werden.
+ *
+ * @section feldbus-slave-kvstore-config Konfiguration
+ * Die folgenden Makros können in feldbus_config.h definiert werden:
+ *
+ * **TURAG_FELDBUS_KVSTORE_KEY_COUNT**:\n
+ * Anzahl der Schlüssel (0 bis TURAG_FELDBUS_KVSTORE_KEY_COUNT - 1).
+ * Jeder Schlüssel belegt 2 Bytes RAM für den Index. Gültige Werte: 1-255,
+ * Standardwert: 32.
+ *
+ * **TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH**:\n
+ * Maximale Länge eines Wertes in Bytes. Beim Kopieren wird ein Puffer
+ * dieser Größe auf dem Stack angelegt. Gültige Werte: 1-252, Standardwert: 16.
+ */
+#ifndef TURAG_FELDBUS_SLAVE_FELDBUS_KVSTORE_H_
+#define TURAG_FELDBUS_SLAVE_FELDBUS_KVSTORE_H_
+
+#include <feldbus/device/feldbus_base.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Sets up the store in the specified part of the static storage
+ * and builds the index.
+ *
+ * If no valid data is found, the area is formatted, so the
+ * store is empty afterwards.
+ *
+ * @param offset	start of the area, must be a multiple of the page size
+ * @param size		size of the area, at most 128 kB. Each half has to hold a
+ * 					header and the longest value of every key, each of them
+ * 					padded to the page size, plus one byte.
+ * @return			false if the area is too small or cannot be accessed
+ */
+bool turag_feldbus_kvstore_init(uint32_t offset, uint32_t size);
+
+/**
+ * Returns the length of the value stored with key or 0 if there is none.
+ */
+uint8_t turag_feldbus_kvstore_length(uint8_t key);
+
+/**
+ * Reads the value stored with key.
+ *
+ * @param key		key of the value
+ * @param value		destination
+ * @param length	expected length of the value
+ * @return			false if there is no value with this length
+ */
+bool turag_feldbus_kvstore_get(uint8_t key, void* value, uint8_t length);
+
+/**
+ * Stores a value. The area is compacted if it runs full.
+ *
+ * @param key		key of the value
+ * @param value		value to store
+ * @param length	length of the value, 1 to TURAG_FELDBUS_KVSTORE_MAX_VALUE_LENGTH
+ * @return			false if the value is invalid, the store is full or writing failed
+ */
+bool turag_feldbus_kvstore_set(uint8_t key, const void* value, uint8_t length);
+
+/**
+ * Removes the value stored with key.
+ *
+ * @return			false if the store is full or writing failed
+ */
+bool turag_feldbus_kvstore_erase(uint8_t key);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // TURAG_FELDBUS_SLAVE_FELDBUS_KVSTORE_H_
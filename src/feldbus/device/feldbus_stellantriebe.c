@@ -32,6 +32,25 @@ void turag_feldbus_stellantriebe_init(feldbus_stellantriebe_command_t* command_s
 }
 
 
+#if TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER
+// command names that do not fit into a package are read in segments
+uint32_t turag_feldbus_device_get_object_size(uint8_t object) {
+    uint8_t index = object - TURAG_FELDBUS_STELLANTRIEBE_OBJECT_COMMAND_NAME;
+
+    if (!command_names || object < TURAG_FELDBUS_STELLANTRIEBE_OBJECT_COMMAND_NAME || index >= command_set_length) {
+        return 0;
+    }
+    return strlen(command_names[index]);
+}
+
+uint8_t turag_feldbus_device_read_object(uint8_t object, uint32_t offset, uint16_t size, uint8_t* buffer) {
+    // offset and size are already checked against the length of the name
+    memcpy(buffer, command_names[object - TURAG_FELDBUS_STELLANTRIEBE_OBJECT_COMMAND_NAME] + offset, size);
+    return 0;
+}
+#endif
+
+
 FeldbusSize_t turag_feldbus_stellantriebe_process_package(const uint8_t* message, FeldbusSize_t message_length, uint8_t* response) {
     // the feldbus base implementation guarantees message_length >= 1 and message[0] >= 1 
 	// so we don't need to check that
@@ -166,6 +185,8 @@ FeldbusSize_t turag_feldbus_stellantriebe_process_package(const uint8_t* message
 
                 FeldbusSize_t length = 0;
 
+                // longer names are cut off, with TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER
+                // the master reads them completely as TURAG_FELDBUS_STELLANTRIEBE_OBJECT_COMMAND_NAME
                 length = strlen(command_names[index]);
 				if (length + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH > TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE) {
 					length = TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH;
@@ -221,7 +242,8 @@ FeldbusSize_t turag_feldbus_stellantriebe_process_package(const uint8_t* message
             if (message[1] == TURAG_FELDBUS_STELLANTRIEBE_STRUCTURED_OUTPUT_SET_STRUCTURE) {
                 // update structure table
                 int8_t i, error = 0;
-                uint8_t size_sum = 0, value_index;
+                uint8_t value_index;
+                FeldbusSize_t size_sum = 0;
                 feldbus_stellantriebe_command_t* command;
 
                 // cancel if the request is too long
@@ -258,8 +280,9 @@ FeldbusSize_t turag_feldbus_stellantriebe_process_package(const uint8_t* message
 
                     structured_output_table[i-2] = command;
 
-                    // cancel if whole package would not fit into buffer
-                    if (size_sum >= TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE) {
+                    // cancel if whole package would not fit into buffer,
+                    // which also holds the address of the answer
+                    if (size_sum + TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH > TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE) {
                         error = 1;
                         break;
                     }
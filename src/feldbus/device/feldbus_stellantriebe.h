@@ -32,6 +32,11 @@
  * 
  * Additionally it is possible to supply a human-understandable description
  * for each value which needs to be supplied in a separate array of strings.
+ * With \ref TURAG_FELDBUS_DEVICE_CONFIG_SEGMENTED_TRANSFER these descriptions
+ * can also be read in segments (see \ref TURAG_FELDBUS_STELLANTRIEBE_OBJECT_COMMAND_NAME),
+ * so they are not limited by the buffer size. This module then implements
+ * turag_feldbus_device_get_object_size() and turag_feldbus_device_read_object(),
+ * the firmware must not define them again.
  * 
  * Ein weiteres wichtiges Feature ist die Ausgabe zusammenhängender 
  * Gerätewerte. Dafür wird im Gerät ein Puffer vorgesehen. Der Client 
@@ -52,7 +57,9 @@
  * **TURAG_FELDBUS_STELLANTRIEBE_STRUCTURED_OUTPUT_BUFFER_SIZE**:\n
  * Gibt an, wieviel Speicher für die zusammenhängende Datenausgabe verwendet
  * werden soll. Diese Zahl beeinflusst, wieviele Gerätewerte maximal gemeinsam
- * ausgegeben werden können.
+ * ausgegeben werden können. Tabellen, deren Ausgabe länger als
+ * \ref TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - \ref TURAG_FELDBUS_DEVICE_CONFIG_ADDRESS_LENGTH
+ * Bytes wäre, werden abgelehnt.
  *
  *
  */
@@ -39,8 +39,17 @@
 /// @brief CRC8-Checksum.
 #define TURAG_FELDBUS_CHECKSUM_CRC8				0x01
 
+/// @brief CRC8-Checksum for short packages, CRC16-Checksum for long packages.
+///
+/// Packages with a total length (including the checksum) of up to
+/// \ref TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED_MAX_CRC8_LENGTH bytes are protected by
+/// a CRC8-checksum (CRC-8/I-CODE), longer packages by a CRC16-checksum (CRC-16/IBM-3740)
+/// which is transmitted with the most significant byte first.
 #define TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED   	0x02
 
+/// @brief Maximum length of a package using the CRC8-checksum in \ref TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED mode.
+#define TURAG_FELDBUS_CHECKSUM_CRC8_16_MIXED_MAX_CRC8_LENGTH	63
+
 ///@}
 
 /**
@@ -117,6 +126,259 @@
 /// @brief Write data to the static data storage at the specified address. Returns 0 on success, an error code on error.
 #define TURAG_FELDBUS_DEVICE_COMMAND_WRITE_TO_STATIC_STORAGE		0x0D
 
+/// @brief Read an object in segments. With only the object ID as argument the device returns the size
+/// of the object (uint32_t) and the largest window it supports (uint8_t, 1 if it only sends one segment per request).
+/// With object ID, offset (uint32_t), sequence number (uint8_t) and optionally the window (uint8_t, default 1)
+/// the device answers with up to window segments. Each segment is a package of its own: the sequence
+/// number followed by up to \ref TURAG_FELDBUS_DEVICE_CONFIG_BUFFER_SIZE - 1 bytes of data. The first segment
+/// starts at offset and carries the sequence number of the request, every further one continues the data and
+/// increments the sequence number. Between the segments the bus stays idle for at least the receive timeout.
+/// A segment that is shorter than the maximum marks the end of the object and ends the window early.
+/// A window also ends before the sequence number reaches \ref TURAG_FELDBUS_DEVICE_SEGMENT_ERROR.
+///
+/// The master waits for the segments of a window before it sends the next request, which continues
+/// behind the last segment it received. A missing or broken segment is requested again the same way.
+/// Any request to the device cancels the segments of the window that were not sent yet.
+/// If the object cannot be read, the device answers with only \ref TURAG_FELDBUS_DEVICE_SEGMENT_ERROR,
+/// e.g. \ref TURAG_FELDBUS_DEVICE_OBJECT_STATIC_STORAGE while a write to the storage is pending.
+/// Unknown objects are answered with an empty package.
+#define TURAG_FELDBUS_DEVICE_COMMAND_READ_SEGMENTED					0x0E
+
+/// @brief Write to the static data storage with a sliding window. Three kinds of packages exist:
+/// - without arguments: the device returns the sequence number of the next frame it accepts,
+///   the sequence number of the next frame that will be programmed, the number of free
+///   queue entries and an error code (0 on success), one byte each. All frames before the
+///   second sequence number are written to the storage.
+/// - sequence number (uint8_t): starts a new transfer with this sequence number, discards queued
+///   frames and clears the error. The device answers like a package without arguments. While a frame
+///   is still being programmed, nothing is reset and the error code is \ref TURAG_FELDBUS_DEVICE_STORAGE_BUSY,
+///   the master repeats the request later.
+/// - sequence number (uint8_t), offset (uint32_t) and data: a frame which is queued and programmed
+///   in the background. Frames are not answered, so the master can send several of them back-to-back.
+///   Frames with an unexpected sequence number or without a free queue entry are dropped and have to
+///   be sent again.
+///
+/// Offset and page size are subject to the same restrictions as for \ref TURAG_FELDBUS_DEVICE_COMMAND_WRITE_TO_STATIC_STORAGE.
+/// As long as frames are queued, \ref TURAG_FELDBUS_DEVICE_COMMAND_READ_FROM_STATIC_STORAGE,
+/// \ref TURAG_FELDBUS_DEVICE_COMMAND_WRITE_TO_STATIC_STORAGE and \ref TURAG_FELDBUS_DEVICE_COMMAND_HASH_STATIC_STORAGE
+/// answer \ref TURAG_FELDBUS_DEVICE_STORAGE_BUSY.
+#define TURAG_FELDBUS_DEVICE_COMMAND_BULK_WRITE						0x0F
+
+/// @brief Return the state of the last write to the static data storage (uint8_t): 0 on success,
+/// an error code on error or \ref TURAG_FELDBUS_DEVICE_STORAGE_BUSY while the write is in progress.
+/// Only available if the device writes asynchronously. In that case
+/// \ref TURAG_FELDBUS_DEVICE_COMMAND_WRITE_TO_STATIC_STORAGE answers 0 as soon as the write is accepted
+/// and \ref TURAG_FELDBUS_DEVICE_STORAGE_BUSY if the previous write is not finished yet.
+#define TURAG_FELDBUS_DEVICE_COMMAND_STATIC_STORAGE_STATUS			0x10
+
+/// @brief Return a hash over a range of the static data storage. Arguments are the algorithm
+/// (TURAG_FELDBUS_DEVICE_HASH_*, uint8_t), offset (uint32_t) and length (uint32_t). The device answers
+/// with an error code (uint8_t) followed by the hash if the error code is 0:
+/// - CRC16: uint16_t, msb first like the checksum of long packages
+/// - MurmurHash3: uint32_t, lsb first like all other values
+///
+/// Error codes are 1 if the range exceeds the storage, \ref TURAG_FELDBUS_DEVICE_HASH_UNKNOWN_ALGORITHM,
+/// \ref TURAG_FELDBUS_DEVICE_HASH_TOO_LONG if the range is longer than the device allows for one request,
+/// \ref TURAG_FELDBUS_DEVICE_STORAGE_BUSY or the error code of the storage. Long ranges have to be
+/// checked piecewise.
+#define TURAG_FELDBUS_DEVICE_COMMAND_HASH_STATIC_STORAGE			0x11
+
+/// @brief Return the processing time statistics. Without arguments the device answers with the
+/// number of stages, the number of histogram buckets per stage and the width of the first bucket
+/// as a power of two (uint8_t each). With a stage (TURAG_FELDBUS_DEVICE_PROFILE_*, uint8_t) as argument
+/// it answers with the minimum and maximum duration of this stage (uint32_t each) followed by the buckets
+/// of the histogram (uint16_t each, saturating). All durations are given in cycles of the device's counter.
+/// Bucket 0 counts durations below 2^width cycles, every further bucket covers twice the range of the
+/// previous one and the last bucket counts all longer durations. A minimum greater than the maximum means
+/// that no duration was recorded. Unknown stages are answered with an empty package.
+/// Only available if the device supports profiling.
+/// \see TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_ALL, \ref TURAG_FELDBUS_DEVICE_COMMAND_RESET_PROFILE
+#define TURAG_FELDBUS_DEVICE_COMMAND_GET_PROFILE					0x12
+
+/// @brief Clears the processing time statistics of all stages.
+#define TURAG_FELDBUS_DEVICE_COMMAND_RESET_PROFILE					0x13
+
+/// @brief Return the traffic statistics. All counters wrap around, so the master should evaluate the
+/// difference between two readings. \ref TURAG_FELDBUS_DEVICE_COMMAND_RESET_PACKAGE_COUNT clears them.
+/// Without arguments the device answers with:
+/// - received bytes, transmitted bytes and received bytes of packages for other devices (uint32_t each)
+/// - number of broadcasts (uint16_t)
+/// - number of device info requests and of reserved packets without counter of their own (uint16_t)
+/// - number of counters of the groups \ref TURAG_FELDBUS_DEVICE_STATISTICS_RESERVED and
+///   \ref TURAG_FELDBUS_DEVICE_STATISTICS_PROTOCOL (uint8_t each)
+///
+/// With a group (TURAG_FELDBUS_DEVICE_STATISTICS_*, uint8_t) and the index of the first counter (uint8_t)
+/// as arguments the device answers with the packet counters of this group (uint16_t each), starting
+/// with the specified one, as many as fit into a package. Unknown groups or indices are answered with an empty package.
+/// Only available if the device supports statistics.
+/// \see TURAG_FELDBUS_DEVICE_COMMAND_PACKAGE_COUNT_ALL
+#define TURAG_FELDBUS_DEVICE_COMMAND_GET_STATISTICS					0x14
+
+/// @brief Read and remove the oldest entries of the packet trace. The device answers with the number of
+/// events that were not recorded since the last request because the trace was full (uint8_t, wrapping), followed by
+/// as many entries as fit into a package, oldest first. Each entry has 8 bytes:
+/// - low 16 bits of the uptime counter when the event occured (uint16_t)
+/// - length of the package, 255 for longer ones (uint8_t)
+/// - event (TURAG_FELDBUS_DEVICE_TRACE_*, uint8_t)
+/// - the first 4 bytes of the package, filled up with 0 for shorter ones
+///
+/// The request itself adds two entries to the trace, so the trace is drained
+/// once an answer contains fewer entries than fit into a package.
+/// Only available if the device supports tracing.
+#define TURAG_FELDBUS_DEVICE_COMMAND_READ_TRACE						0x15
+
+/// @brief Read and remove the oldest records of the debug output. The device answers with the number of
+/// records that were dropped since the last request because the buffer was full (uint8_t, wrapping),
+/// followed by as many complete records as fit into a package, oldest first. Each record starts with its type
+/// (TURAG_FELDBUS_DEVICE_LOG_*, uint8_t) followed by its value. The host formats the values.
+/// Only available if the device was built with debug output.
+#define TURAG_FELDBUS_DEVICE_COMMAND_READ_LOG						0x16
+
+/// @brief First command ID that can be used by device protocols for their own reserved packets.
+/// All IDs below are reserved for the base protocol.
+#define TURAG_FELDBUS_DEVICE_COMMAND_USER_FIRST						0x80
+
+
+///@}
+
+/**
+ * @name Objects for TURAG_FELDBUS_DEVICE_COMMAND_READ_SEGMENTED
+ * @{
+ */
+
+/// @brief Device name (without truncation)
+#define TURAG_FELDBUS_DEVICE_OBJECT_DEVICE_NAME					0x00
+
+/// @brief Version info string (without truncation)
+#define TURAG_FELDBUS_DEVICE_OBJECT_VERSIONINFO					0x01
+
+/// @brief Complete static storage
+#define TURAG_FELDBUS_DEVICE_OBJECT_STATIC_STORAGE				0x02
+
+/// @brief First object ID that is available for device specific objects.
+#define TURAG_FELDBUS_DEVICE_OBJECT_USER_FIRST					0x80
+
+/// @brief Answer to \ref TURAG_FELDBUS_DEVICE_COMMAND_READ_SEGMENTED if the object cannot be read.
+/// Requests must not use this value as sequence number, they are not answered.
+#define TURAG_FELDBUS_DEVICE_SEGMENT_ERROR						0xFF
+
+///@}
+
+/// @brief Error code of static storage accesses while a write is still in progress.
+#define TURAG_FELDBUS_DEVICE_STORAGE_BUSY						0xFF
+
+/**
+ * @name Algorithms for TURAG_FELDBUS_DEVICE_COMMAND_HASH_STATIC_STORAGE
+ * @{
+ */
+
+/// @brief CRC-16/IBM-3740 as calculated by turag_crc16_calculate()
+#define TURAG_FELDBUS_DEVICE_HASH_CRC16							0x00
+
+/// @brief MurmurHash3 x86_32 with seed 0 as calculated by murmurhash3_x86_32()
+#define TURAG_FELDBUS_DEVICE_HASH_MURMUR3						0x01
+
+/// @brief Error code for an unknown algorithm
+#define TURAG_FELDBUS_DEVICE_HASH_UNKNOWN_ALGORITHM				0xFE
+
+/// @brief Error code if the range is too long to be hashed within one request
+#define TURAG_FELDBUS_DEVICE_HASH_TOO_LONG						0xFD
+
+///@}
+
+/**
+ * @name Stages for TURAG_FELDBUS_DEVICE_COMMAND_GET_PROFILE
+ * @{
+ */
+
+/// @brief From the reception of a complete package until turag_feldbus_do_processing() takes it
+#define TURAG_FELDBUS_DEVICE_PROFILE_RX_WAIT					0x00
+
+/// @brief Checking the checksum of a received package
+#define TURAG_FELDBUS_DEVICE_PROFILE_CHECKSUM					0x01
+
+/// @brief Processing a package, including the packet processor of the device
+#define TURAG_FELDBUS_DEVICE_PROFILE_PROCESSING					0x02
+
+/// @brief From the start of the transmission of an answer until it is complete
+#define TURAG_FELDBUS_DEVICE_PROFILE_TRANSMIT					0x03
+
+/// @brief Number of stages
+#define TURAG_FELDBUS_DEVICE_PROFILE_STAGE_COUNT				4
+
+///@}
+
+/**
+ * @name Counter groups for TURAG_FELDBUS_DEVICE_COMMAND_GET_STATISTICS
+ * @{
+ */
+
+/// @brief Reserved packets, indexed by the command ID (TURAG_FELDBUS_DEVICE_COMMAND_*)
+#define TURAG_FELDBUS_DEVICE_STATISTICS_RESERVED				0x00
+
+/// @brief Packets of the device protocol, indexed by their first byte. The counter with
+/// index 0 counts all packets whose first byte has no counter of its own.
+#define TURAG_FELDBUS_DEVICE_STATISTICS_PROTOCOL				0x01
+
+///@}
+
+/**
+ * @name Events for TURAG_FELDBUS_DEVICE_COMMAND_READ_TRACE
+ * @{
+ */
+
+/// @brief A package for this device was received completely and waits for processing
+#define TURAG_FELDBUS_DEVICE_TRACE_RECEIVED						0x00
+
+/// @brief A package for this device was lost because it could not be stored (no length and data)
+#define TURAG_FELDBUS_DEVICE_TRACE_LOST							0x01
+
+/// @brief A package for this device did not fit into the buffer (no length and data)
+#define TURAG_FELDBUS_DEVICE_TRACE_OVERFLOW						0x02
+
+/// @brief A package for this device was dropped because of a wrong checksum
+#define TURAG_FELDBUS_DEVICE_TRACE_CHECKSUM_ERROR				0x03
+
+/// @brief A package was processed and answered (length and data of the answer without address and checksum)
+#define TURAG_FELDBUS_DEVICE_TRACE_ANSWERED						0x04
+
+/// @brief A package was processed without sending an answer (data of the package)
+#define TURAG_FELDBUS_DEVICE_TRACE_NO_ANSWER					0x05
+
+///@}
+
+/**
+ * @name Record types for TURAG_FELDBUS_DEVICE_COMMAND_READ_LOG
+ * The types are named after the debug function that creates the record.
+ * @{
+ */
+
+/// @brief print_text(): length (uint8_t) followed by the characters
+#define TURAG_FELDBUS_DEVICE_LOG_TEXT							0x00
+
+/// @brief print_char(): uint8_t, printed hexadecimal
+#define TURAG_FELDBUS_DEVICE_LOG_CHAR							0x01
+
+/// @brief print_short(): uint16_t, printed hexadecimal followed by a newline
+#define TURAG_FELDBUS_DEVICE_LOG_SHORT							0x02
+
+/// @brief print_short_nn(): uint16_t, printed hexadecimal
+#define TURAG_FELDBUS_DEVICE_LOG_SHORT_NN						0x03
+
+/// @brief print_sshort(): int16_t, printed hexadecimal with sign followed by a newline
+#define TURAG_FELDBUS_DEVICE_LOG_SSHORT							0x04
+
+/// @brief print_sshort_nn(): int16_t, printed hexadecimal with sign
+#define TURAG_FELDBUS_DEVICE_LOG_SSHORT_NN						0x05
+
+/// @brief print_long(): uint32_t, printed hexadecimal followed by a newline
+#define TURAG_FELDBUS_DEVICE_LOG_LONG							0x06
+
+/// @brief print_short_d(): int16_t, printed decimal followed by a newline
+#define TURAG_FELDBUS_DEVICE_LOG_SHORT_D						0x07
+
+/// @brief print_slong(): int32_t, printed hexadecimal with sign followed by a newline
+#define TURAG_FELDBUS_DEVICE_LOG_SLONG							0x08
 
 ///@}
 /**
@@ -64,6 +64,17 @@
 #define TURAG_FELDBUS_STELLANTRIEBE_COMMAND_INFO_GET_NAME (0x03)
 ///@}
 
+/**
+ * @name objects for TURAG_FELDBUS_DEVICE_COMMAND_READ_SEGMENTED
+ * Namen, die nicht in ein Paket passen, werden von
+ * \ref TURAG_FELDBUS_STELLANTRIEBE_COMMAND_INFO_GET_NAME gekürzt. Vollständig
+ * liest man sie als Objekt TURAG_FELDBUS_STELLANTRIEBE_OBJECT_COMMAND_NAME + key - 1,
+ * also für die ersten 128 Einträge des Command Sets.
+ * @{
+ */
+#define TURAG_FELDBUS_STELLANTRIEBE_OBJECT_COMMAND_NAME (TURAG_FELDBUS_DEVICE_OBJECT_USER_FIRST)
+///@}
+
 /**
  * @name structured output
  * @{
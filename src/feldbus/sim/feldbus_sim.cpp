@@ -0,0 +1,679 @@
+#include "feldbus_sim.h"
+#include <feldbus/device/feldbus_base.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 8 data bits, 1 start bit, 1 stop bit
+constexpr unsigned bits_per_byte = 10;
+
+// depth of the receive fifo of the modeled UART. Bytes exceeding
+// this depth while the receive interrupt is disabled are lost.
+constexpr size_t rx_fifo_depth = 2;
+
+// receive timeout used if the byte timing is disabled
+constexpr uint32_t unpaced_receive_timeout_us = 100;
+
+// capacity of the capture buffer used without transport
+constexpr size_t capture_size = 1024;
+
+struct RxByte {
+	uint8_t data;
+	Clock::time_point due;
+};
+
+struct Sim {
+	turag_feldbus_sim_config_t config;
+
+	int device_fd = -1;
+	int bus_fd = -1;
+	int pty_slave_fd = -1;
+	int wake_fd[2] = {-1, -1};
+	char pty_name[128] = {0};
+
+	std::thread thread;
+	std::thread::id isr_thread;
+	std::atomic<bool> running{false};
+
+	// held while a simulated interrupt is executed or while
+	// the main context is interrupt protected
+	std::mutex isr_mutex;
+	// notified after each simulated interrupt to wake up turag_feldbus_device_goto_sleep()
+	std::condition_variable isr_done;
+
+	std::atomic<bool> rx_enabled{false};
+	std::atomic<bool> dre_enabled{false};
+	std::atomic<bool> tx_enabled{false};
+	std::atomic<bool> rts{false};
+	std::atomic<bool> uptime_enabled{false};
+
+	// the following members are accessed with isr_mutex held
+	Clock::duration byte_time{0};
+	Clock::duration receive_timeout{0};
+	std::deque<RxByte> rx_fifo;
+	Clock::time_point rx_last_due;
+	// modeled arrival of the byte passed to turag_feldbus_device_byte_received()
+	Clock::time_point rx_current_due;
+	bool timeout_armed = false;
+	Clock::time_point timeout_deadline;
+	Clock::time_point tx_done;
+	Clock::time_point next_uptime_tick;
+
+	// simulated DMA (TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER)
+	uint8_t* block_buffer = nullptr;
+	size_t block_size = 0;
+	size_t block_length = 0;
+	Clock::time_point block_idle_deadline;
+	bool block_tx_pending = false;
+
+	uint8_t capture[capture_size];
+	size_t capture_length = 0;
+
+	std::atomic<uint32_t> rx_bytes{0};
+	std::atomic<uint32_t> rx_dropped{0};
+	std::atomic<uint32_t> tx_bytes{0};
+	std::atomic<uint32_t> interrupts{0};
+	std::atomic<uint32_t> bus_assertions{0};
+};
+
+Sim sim;
+
+// true while the current thread holds isr_mutex through turag_feldbus_device_begin_interrupt_protect()
+thread_local bool interrupt_protected = false;
+
+
+bool in_isr_context() {
+	return sim.running && std::this_thread::get_id() == sim.isr_thread;
+}
+
+void wake_isr_thread() {
+	if (sim.running) {
+		char c = 0;
+		ssize_t result = write(sim.wake_fd[1], &c, 1);
+		(void)result;
+	}
+}
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER
+// Locks isr_mutex unless the calling context already excludes the
+// simulated interrupts.
+std::unique_lock<std::mutex> lock_unless_isr() {
+	std::unique_lock<std::mutex> lock(sim.isr_mutex, std::defer_lock);
+	if (sim.running && !in_isr_context() && !interrupt_protected) {
+		lock.lock();
+	}
+	return lock;
+}
+#endif
+
+// Once an interrupt is disabled from main context, the corresponding
+// handler must not be executed any more - not even one that has already
+// been started by the simulation thread. We wait for it to finish.
+void sync_with_isr() {
+	if (sim.running && !in_isr_context() && !interrupt_protected) {
+		std::lock_guard<std::mutex> lock(sim.isr_mutex);
+	}
+}
+
+void close_fd(int& fd) {
+	if (fd >= 0) {
+		close(fd);
+		fd = -1;
+	}
+}
+
+void read_from_bus(Clock::time_point now) {
+	uint8_t buffer[256];
+	ssize_t length;
+
+	while ((length = read(sim.device_fd, buffer, sizeof(buffer))) > 0) {
+		std::lock_guard<std::mutex> lock(sim.isr_mutex);
+
+		for (ssize_t i = 0; i < length; ++i) {
+			// received bytes arrive one after the other, each one
+			// after a full byte time
+			sim.rx_last_due = std::max(now, sim.rx_last_due) + sim.byte_time;
+			sim.rx_fifo.push_back({buffer[i], sim.rx_last_due});
+		}
+	}
+}
+
+// executes all interrupts that are due and returns the time of the next event
+Clock::time_point run_interrupts(Clock::time_point now) {
+	Clock::time_point next = now + std::chrono::milliseconds(100);
+
+	std::unique_lock<std::mutex> lock(sim.isr_mutex);
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER
+	// DMA reception: no interrupt per byte, but one as soon as
+	// the line is idle for the receive timeout
+	if (sim.block_buffer) {
+		while (!sim.rx_fifo.empty() && sim.rx_fifo.front().due <= now) {
+			if (sim.block_length < sim.block_size) {
+				sim.block_buffer[sim.block_length] = sim.rx_fifo.front().data;
+			}
+			++sim.block_length;
+			++sim.rx_bytes;
+			sim.block_idle_deadline = sim.rx_fifo.front().due + sim.receive_timeout;
+			sim.rx_fifo.pop_front();
+		}
+		if (sim.block_length > 0) {
+			if (sim.block_idle_deadline <= now) {
+				size_t length = sim.block_length;
+				sim.block_buffer = nullptr;
+				sim.block_length = 0;
+				++sim.interrupts;
+				turag_feldbus_device_block_received(length);
+			} else {
+				next = std::min(next, sim.block_idle_deadline);
+			}
+		}
+	}
+	if (!sim.block_buffer) {
+		// no reception started: the UART keeps some bytes,
+		// the rest gets lost
+		size_t pending = 0;
+		for (auto it = sim.rx_fifo.begin(); it != sim.rx_fifo.end(); ) {
+			if (it->due <= now && ++pending > rx_fifo_depth) {
+				it = sim.rx_fifo.erase(it);
+				++sim.rx_dropped;
+			} else {
+				++it;
+			}
+		}
+	}
+	if (!sim.rx_fifo.empty()) {
+		next = std::min(next, std::max(now, sim.rx_fifo.front().due));
+	}
+
+	// DMA transmission complete
+	if (sim.block_tx_pending) {
+		if (sim.tx_done <= now) {
+			sim.block_tx_pending = false;
+			++sim.interrupts;
+			turag_feldbus_device_block_transmitted();
+		} else {
+			next = std::min(next, sim.tx_done);
+		}
+	}
+#else
+	// receive complete
+	if (!sim.rx_fifo.empty()) {
+		if (sim.rx_enabled) {
+			// if the line was idle long enough before the byte arrived,
+			// the receive timeout comes first, even if we are late
+			if (sim.rx_fifo.front().due <= now &&
+					!(sim.timeout_armed && sim.timeout_deadline <= sim.rx_fifo.front().due)) {
+				sim.rx_current_due = sim.rx_fifo.front().due;
+				uint8_t data = sim.rx_fifo.front().data;
+				sim.rx_fifo.pop_front();
+				++sim.rx_bytes;
+				++sim.interrupts;
+				turag_feldbus_device_byte_received(data);
+			}
+		} else {
+			// interrupt is disabled: the UART keeps some bytes,
+			// the rest gets lost
+			size_t pending = 0;
+			for (auto it = sim.rx_fifo.begin(); it != sim.rx_fifo.end(); ) {
+				if (it->due <= now && ++pending > rx_fifo_depth) {
+					it = sim.rx_fifo.erase(it);
+					++sim.rx_dropped;
+				} else {
+					++it;
+				}
+			}
+		}
+		if (!sim.rx_fifo.empty()) {
+			next = std::min(next, std::max(now, sim.rx_fifo.front().due));
+		}
+	}
+
+	// receive timeout, unless the next byte arrived before it expired
+	if (sim.timeout_armed && !(sim.rx_enabled && !sim.rx_fifo.empty() && sim.rx_fifo.front().due < sim.timeout_deadline)) {
+		if (sim.timeout_deadline <= now) {
+			sim.timeout_armed = false;
+			++sim.interrupts;
+			turag_feldbus_device_receive_timeout_occured();
+		} else {
+			next = std::min(next, sim.timeout_deadline);
+		}
+	}
+
+	// data register empty: the UART is double buffered, so the
+	// next byte can be written as soon as the previous one is being shifted out.
+	if (sim.dre_enabled) {
+		Clock::time_point dre_time = sim.tx_done - sim.byte_time;
+		if (dre_time <= now) {
+			++sim.interrupts;
+			turag_feldbus_device_ready_to_transmit();
+			next = std::min(next, sim.tx_done - sim.byte_time);
+		} else {
+			next = std::min(next, dre_time);
+		}
+	}
+
+	// transmission complete
+	if (sim.tx_enabled && !sim.dre_enabled) {
+		if (sim.tx_done <= now) {
+			++sim.interrupts;
+			turag_feldbus_device_transmission_complete();
+		} else {
+			next = std::min(next, sim.tx_done);
+		}
+	}
+#endif
+
+	// uptime counter
+#if TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY > 0
+	if (sim.uptime_enabled) {
+		if (sim.next_uptime_tick <= now) {
+			sim.next_uptime_tick += std::chrono::microseconds(1000000 / TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY);
+			++sim.interrupts;
+			turag_feldbus_device_increase_uptime_counter();
+		}
+		next = std::min(next, sim.next_uptime_tick);
+	}
+#endif
+
+	lock.unlock();
+	sim.isr_done.notify_all();
+
+	return next;
+}
+
+void isr_thread_main() {
+	while (sim.running) {
+		Clock::time_point now = Clock::now();
+
+		read_from_bus(now);
+		Clock::time_point next = run_interrupts(now);
+
+		now = Clock::now();
+		if (next > now) {
+			auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(next - now);
+			struct timespec timeout;
+			timeout.tv_sec = wait.count() / 1000000000;
+			timeout.tv_nsec = wait.count() % 1000000000;
+
+			struct pollfd fds[2];
+			fds[0].fd = sim.device_fd;
+			fds[0].events = POLLIN;
+			fds[1].fd = sim.wake_fd[0];
+			fds[1].events = POLLIN;
+
+			if (ppoll(fds, 2, &timeout, nullptr) > 0 && (fds[1].revents & POLLIN)) {
+				char buffer[64];
+				while (read(sim.wake_fd[0], buffer, sizeof(buffer)) > 0);
+			}
+		}
+	}
+}
+
+bool set_nonblocking(int fd) {
+	int flags = fcntl(fd, F_GETFL);
+	return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool open_pty() {
+	sim.device_fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if (sim.device_fd < 0 || grantpt(sim.device_fd) != 0 || unlockpt(sim.device_fd) != 0) {
+		return false;
+	}
+	if (ptsname_r(sim.device_fd, sim.pty_name, sizeof(sim.pty_name)) != 0) {
+		return false;
+	}
+
+	// We keep the slave side open ourselves. This way the line settings
+	// are kept and reads don't fail while no bus master is connected.
+	sim.pty_slave_fd = open(sim.pty_name, O_RDWR | O_NOCTTY);
+	if (sim.pty_slave_fd < 0) {
+		return false;
+	}
+	struct termios tio;
+	if (tcgetattr(sim.pty_slave_fd, &tio) != 0) {
+		return false;
+	}
+	cfmakeraw(&tio);
+	return tcsetattr(sim.pty_slave_fd, TCSANOW, &tio) == 0;
+}
+
+bool open_socketpair() {
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+		return false;
+	}
+	sim.device_fd = fds[0];
+	sim.bus_fd = fds[1];
+	return true;
+}
+
+} // namespace
+
+
+
+extern "C" void turag_feldbus_sim_default_config(turag_feldbus_sim_config_t* config) {
+	config->transport = TURAG_FELDBUS_SIM_SOCKETPAIR;
+	config->baudrate = 115200;
+	config->receive_timeout_us = 0;
+}
+
+extern "C" int turag_feldbus_sim_open(const turag_feldbus_sim_config_t* config) {
+	if (sim.running) {
+		errno = EBUSY;
+		return -1;
+	}
+
+	if (config) {
+		sim.config = *config;
+	} else {
+		turag_feldbus_sim_default_config(&sim.config);
+	}
+
+	if (sim.config.baudrate > 0) {
+		sim.byte_time = std::chrono::nanoseconds(turag_feldbus_sim_bus_time_ns(1, sim.config.baudrate));
+	} else {
+		sim.byte_time = Clock::duration::zero();
+	}
+
+	if (sim.config.receive_timeout_us > 0) {
+		sim.receive_timeout = std::chrono::microseconds(sim.config.receive_timeout_us);
+	} else if (sim.config.baudrate > 0) {
+		sim.receive_timeout = std::chrono::nanoseconds(15ull * 1000000000ull / sim.config.baudrate);
+	} else {
+		sim.receive_timeout = std::chrono::microseconds(unpaced_receive_timeout_us);
+	}
+
+	bool ok = sim.config.transport == TURAG_FELDBUS_SIM_PTY ? open_pty() : open_socketpair();
+	ok = ok && pipe(sim.wake_fd) == 0;
+	ok = ok && set_nonblocking(sim.device_fd) && set_nonblocking(sim.wake_fd[0]) && set_nonblocking(sim.wake_fd[1]);
+
+	if (!ok) {
+		int error = errno;
+		close_fd(sim.device_fd);
+		close_fd(sim.bus_fd);
+		close_fd(sim.pty_slave_fd);
+		close_fd(sim.wake_fd[0]);
+		close_fd(sim.wake_fd[1]);
+		sim.pty_name[0] = 0;
+		errno = error;
+		return -1;
+	}
+
+	// writing to a socket whose peer was closed must not kill the device
+	signal(SIGPIPE, SIG_IGN);
+
+	Clock::time_point now = Clock::now();
+	sim.rx_fifo.clear();
+	sim.rx_last_due = now;
+	sim.tx_done = now;
+	sim.timeout_armed = false;
+	sim.block_length = 0;
+	sim.block_tx_pending = false;
+	sim.next_uptime_tick = now;
+
+	// the simulation thread must not execute any interrupt before
+	// it knows about its own identity
+	std::lock_guard<std::mutex> lock(sim.isr_mutex);
+	sim.running = true;
+	sim.thread = std::thread(isr_thread_main);
+	sim.isr_thread = sim.thread.get_id();
+	return 0;
+}
+
+extern "C" void turag_feldbus_sim_close(void) {
+	if (sim.running) {
+		sim.running = false;
+		char c = 0;
+		ssize_t result = write(sim.wake_fd[1], &c, 1);
+		(void)result;
+		sim.thread.join();
+	}
+	close_fd(sim.device_fd);
+	close_fd(sim.bus_fd);
+	close_fd(sim.pty_slave_fd);
+	close_fd(sim.wake_fd[0]);
+	close_fd(sim.wake_fd[1]);
+	sim.pty_name[0] = 0;
+}
+
+extern "C" int turag_feldbus_sim_bus_fd(void) {
+	return sim.bus_fd;
+}
+
+extern "C" const char* turag_feldbus_sim_pty_name(void) {
+	return sim.pty_name[0] ? sim.pty_name : nullptr;
+}
+
+extern "C" uint64_t turag_feldbus_sim_bus_time_ns(uint32_t bytes, uint32_t baudrate) {
+	if (baudrate == 0) {
+		return 0;
+	}
+	return (uint64_t)bytes * bits_per_byte * 1000000000ull / baudrate;
+}
+
+extern "C" void turag_feldbus_sim_get_stats(turag_feldbus_sim_stats_t* stats) {
+	stats->rx_bytes = sim.rx_bytes;
+	stats->rx_dropped = sim.rx_dropped;
+	stats->tx_bytes = sim.tx_bytes;
+	stats->interrupts = sim.interrupts;
+	stats->bus_assertions = sim.bus_assertions;
+}
+
+extern "C" bool turag_feldbus_sim_dre_interrupt_enabled(void) {
+	return sim.dre_enabled;
+}
+
+extern "C" bool turag_feldbus_sim_tx_interrupt_enabled(void) {
+	return sim.tx_enabled;
+}
+
+extern "C" bool turag_feldbus_sim_rx_interrupt_enabled(void) {
+	return sim.rx_enabled;
+}
+
+extern "C" bool turag_feldbus_sim_rts_enabled(void) {
+	return sim.rts;
+}
+
+extern "C" size_t turag_feldbus_sim_receive_block(const uint8_t* data, size_t length) {
+	if (!sim.block_buffer) {
+		return 0;
+	}
+	memcpy(sim.block_buffer, data, std::min(length, sim.block_size));
+	sim.block_buffer = nullptr;
+	return length;
+}
+
+extern "C" bool turag_feldbus_sim_block_transmit_pending(void) {
+	return sim.block_tx_pending;
+}
+
+extern "C" size_t turag_feldbus_sim_read_transmitted(uint8_t* buffer, size_t size) {
+	size_t length = std::min(size, sim.capture_length);
+	memcpy(buffer, sim.capture, length);
+	memmove(sim.capture, sim.capture + length, sim.capture_length - length);
+	sim.capture_length -= length;
+	return length;
+}
+
+
+
+/*
+ * hardware interface
+ */
+extern "C" void turag_feldbus_hardware_init(void) {
+	if (sim.running) {
+		std::lock_guard<std::mutex> lock(sim.isr_mutex);
+		sim.next_uptime_tick = Clock::now();
+	}
+	sim.uptime_enabled = true;
+	wake_isr_thread();
+}
+
+extern "C" void turag_feldbus_device_rts_off(void) {
+	sim.rts = false;
+}
+
+extern "C" void turag_feldbus_device_rts_on(void) {
+	sim.rts = true;
+}
+
+extern "C" void turag_feldbus_device_activate_dre_interrupt(void) {
+	sim.dre_enabled = true;
+	wake_isr_thread();
+}
+
+extern "C" void turag_feldbus_device_deactivate_dre_interrupt(void) {
+	sim.dre_enabled = false;
+	sync_with_isr();
+}
+
+extern "C" void turag_feldbus_device_activate_rx_interrupt(void) {
+	sim.rx_enabled = true;
+	wake_isr_thread();
+}
+
+extern "C" void turag_feldbus_device_deactivate_rx_interrupt(void) {
+	sim.rx_enabled = false;
+	sync_with_isr();
+}
+
+extern "C" void turag_feldbus_device_activate_tx_interrupt(void) {
+	sim.tx_enabled = true;
+	wake_isr_thread();
+}
+
+extern "C" void turag_feldbus_device_deactivate_tx_interrupt(void) {
+	sim.tx_enabled = false;
+	sync_with_isr();
+}
+
+extern "C" void turag_feldbus_device_start_receive_timeout(void) {
+	// only called from turag_feldbus_device_byte_received() and
+	// turag_feldbus_device_transmission_complete(), so isr_mutex is held
+	if (sim.running) {
+		// the timeout runs from the modeled arrival of the byte or the end of
+		// the transmission, so the gaps between packages are kept even if the
+		// simulation thread is late
+		sim.timeout_armed = true;
+		sim.timeout_deadline = std::max(sim.rx_current_due, sim.tx_done) + sim.receive_timeout;
+	}
+}
+
+extern "C" void turag_feldbus_device_begin_interrupt_protect(void) {
+	if (sim.running && !in_isr_context()) {
+		sim.isr_mutex.lock();
+		interrupt_protected = true;
+	}
+}
+
+extern "C" void turag_feldbus_device_end_interrupt_protect(void) {
+	if (interrupt_protected) {
+		interrupt_protected = false;
+		sim.isr_mutex.unlock();
+	}
+}
+
+extern "C" void turag_feldbus_device_transmit_byte(uint8_t byte) {
+	++sim.tx_bytes;
+
+	if (sim.running) {
+		// only called from turag_feldbus_device_ready_to_transmit(), so isr_mutex is held
+		Clock::time_point now = Clock::now();
+		sim.tx_done = std::max(now, sim.tx_done) + sim.byte_time;
+
+		if (write(sim.device_fd, &byte, 1) != 1) {
+			// nobody is listening: the byte gets lost on the bus
+		}
+	} else if (sim.capture_length < capture_size) {
+		sim.capture[sim.capture_length++] = byte;
+	}
+}
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER
+extern "C" void turag_feldbus_device_transmit_block(const uint8_t* data, FeldbusSize_t length) {
+	std::unique_lock<std::mutex> lock = lock_unless_isr();
+
+	sim.tx_bytes += length;
+	sim.block_tx_pending = true;
+
+	if (sim.running) {
+		Clock::time_point now = Clock::now();
+		sim.tx_done = std::max(now, sim.tx_done) + length * sim.byte_time;
+
+		if (write(sim.device_fd, data, length) != (ssize_t)length) {
+			// nobody is listening: the data gets lost on the bus
+		}
+		lock.unlock();
+		wake_isr_thread();
+	} else {
+		size_t copy = std::min((size_t)length, capture_size - sim.capture_length);
+		memcpy(sim.capture + sim.capture_length, data, copy);
+		sim.capture_length += copy;
+	}
+}
+
+extern "C" void turag_feldbus_device_start_block_receive(uint8_t* buffer, FeldbusSize_t size) {
+	std::unique_lock<std::mutex> lock = lock_unless_isr();
+
+	sim.block_buffer = buffer;
+	sim.block_size = size;
+	sim.block_length = 0;
+
+	if (lock.owns_lock()) {
+		lock.unlock();
+	}
+	wake_isr_thread();
+}
+#endif
+
+extern "C" void turag_feldbus_device_assert_low(void) {
+	++sim.bus_assertions;
+}
+
+#if TURAG_FELDBUS_DEVICE_CONFIG_PROFILING
+extern "C" uint32_t turag_feldbus_device_get_cycle_count(void) {
+	// one cycle per nanosecond
+	return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+#endif
+
+extern "C" void turag_feldbus_device_goto_sleep(void) {
+	// Leave light sleep mode with the next interrupt. The wait is limited,
+	// because interrupts that occured before we got here don't wake us up.
+	if (!sim.running || in_isr_context()) {
+		return;
+	}
+
+	if (interrupt_protected) {
+		// called from turag_feldbus_do_processing() with isr_mutex held.
+		// Waiting releases it temporarily.
+		std::unique_lock<std::mutex> lock(sim.isr_mutex, std::adopt_lock);
+		sim.isr_done.wait_for(lock, std::chrono::milliseconds(1));
+		lock.release();
+	} else {
+		std::unique_lock<std::mutex> lock(sim.isr_mutex);
+		sim.isr_done.wait_for(lock, std::chrono::milliseconds(1));
+	}
+}
@@ -0,0 +1,231 @@
+/**
+ *  @brief		Host-side simulation of the TURAG-Feldbus hardware interface
+ *  @file		feldbus_sim.h
+ *  @ingroup	feldbus-slave-sim
+ */
+
+/**
+ * @defgroup feldbus-slave-sim Host-Simulation
+ * @ingroup feldbus-slave
+ *
+ * Implementation of the hardware interface of the base implementation
+ * (see \ref feldbus-slave-base-avr) for Linux hosts. It allows the device stack
+ * to be compiled and run on a build server without any MCU.
+ *
+ * The simulated UART is connected to a socketpair or to a pseudo terminal.
+ * A background thread plays the role of the interrupt controller: it delivers
+ * received bytes with a modeled baud rate (8N1, 10 bits per byte), generates
+ * the data-register-empty and transmission-complete interrupts, runs the
+ * receive timeout and calls turag_feldbus_device_increase_uptime_counter()
+ * with \ref TURAG_FELDBUS_DEVICE_CONFIG_UPTIME_FREQUENCY. Only one simulated
+ * interrupt is executed at a time and never concurrently with a section
+ * protected by turag_feldbus_device_begin_interrupt_protect(), just like on
+ * a single core controller.
+ *
+ * Usage:
+ * - call turag_feldbus_sim_open() before turag_feldbus_device_init()
+ * - talk to the device through turag_feldbus_sim_bus_fd() or
+ *   the pseudo terminal named by turag_feldbus_sim_pty_name()
+ * - call turag_feldbus_do_processing() from the main loop as usual
+ *
+ * If turag_feldbus_sim_open() is not called, all hardware functions merely
+ * record their state. In this case the caller takes the role of the interrupt
+ * controller and calls the interrupt interface functions itself, which
+ * is useful for deterministic benchmarks. Transmitted bytes can then be
+ * fetched with turag_feldbus_sim_read_transmitted().
+ *
+ * If \ref TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER is set, the UART is simulated with
+ * DMA instead: received bytes are copied into the buffer passed to
+ * turag_feldbus_device_start_block_receive() without any interrupt and
+ * turag_feldbus_device_block_received() is called once the line is idle for the
+ * receive timeout. turag_feldbus_device_block_transmitted() is called after
+ * the last byte of a block left the line.
+ *
+ * The simulation provides turag_feldbus_device_goto_sleep(), so the device
+ * firmware must not define it.
+ *
+ * The source file needs to be compiled as part of the device project (C++11 or newer,
+ * linked with -pthread) because it depends on feldbus_config.h.
+ */
+
+#ifndef TURAG_FELDBUS_SIM_FELDBUS_SIM_H_
+#define TURAG_FELDBUS_SIM_FELDBUS_SIM_H_
+
+#ifdef __cplusplus
+# include <cstddef>
+# include <cstdint>
+#else
+# include <stddef.h>
+# include <stdint.h>
+# include <stdbool.h>
+#endif
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/// \brief Transport the simulated UART is connected to.
+typedef enum {
+	/// The bus master side is available through turag_feldbus_sim_bus_fd().
+	TURAG_FELDBUS_SIM_SOCKETPAIR,
+	/// The bus master side is the pseudo terminal named by turag_feldbus_sim_pty_name().
+	TURAG_FELDBUS_SIM_PTY
+} turag_feldbus_sim_transport_t;
+
+/// \brief Configuration of the simulated hardware.
+typedef struct {
+	/// Transport to use.
+	turag_feldbus_sim_transport_t transport;
+	/// Modeled baud rate. 0 disables the byte timing (bytes are processed as fast as possible).
+	uint32_t baudrate;
+	/// Receive timeout in microseconds. If 0, 15 bit times of the modeled baud rate are used.
+	uint32_t receive_timeout_us;
+} turag_feldbus_sim_config_t;
+
+/// \brief Counters of the simulated hardware.
+typedef struct {
+	/// Bytes passed to turag_feldbus_device_byte_received().
+	uint32_t rx_bytes;
+	/// Bytes lost because the receive interrupt was disabled for too long.
+	uint32_t rx_dropped;
+	/// Bytes passed to turag_feldbus_device_transmit_byte().
+	uint32_t tx_bytes;
+	/// Number of simulated interrupts that were executed.
+	uint32_t interrupts;
+	/// Number of calls to turag_feldbus_device_assert_low().
+	uint32_t bus_assertions;
+} turag_feldbus_sim_stats_t;
+
+
+/**
+ * Fills config with default values: socketpair, 115200 baud
+ * and a receive timeout of 15 bit times.
+ */
+void turag_feldbus_sim_default_config(turag_feldbus_sim_config_t* config);
+
+/**
+ * Opens the transport and starts the simulated interrupt controller.
+ * @param config configuration to use or 0 for the defaults
+ * @return 0 on success, -1 on error (errno is set accordingly)
+ */
+int turag_feldbus_sim_open(const turag_feldbus_sim_config_t* config);
+
+/**
+ * Stops the simulated interrupt controller and closes the transport.
+ */
+void turag_feldbus_sim_close(void);
+
+/**
+ * Returns the file descriptor the bus master uses to talk to the device
+ * or -1 if the socketpair transport is not active.
+ */
+int turag_feldbus_sim_bus_fd(void);
+
+/**
+ * Returns the path of the pseudo terminal the bus master can open or 0
+ * if the pty transport is not active.
+ */
+const char* turag_feldbus_sim_pty_name(void);
+
+/**
+ * Returns the time in nanoseconds that is required to transfer the given number
+ * of bytes with the modeled baud rate.
+ */
+uint64_t turag_feldbus_sim_bus_time_ns(uint32_t bytes, uint32_t baudrate);
+
+/**
+ * Copies the counters of the simulated hardware into stats.
+ */
+void turag_feldbus_sim_get_stats(turag_feldbus_sim_stats_t* stats);
+
+/**
+ * Returns whether the data register empty interrupt is enabled.
+ */
+bool turag_feldbus_sim_dre_interrupt_enabled(void);
+
+/**
+ * Returns whether the transmission complete interrupt is enabled.
+ */
+bool turag_feldbus_sim_tx_interrupt_enabled(void);
+
+/**
+ * Returns whether the receive interrupt is enabled.
+ */
+bool turag_feldbus_sim_rx_interrupt_enabled(void);
+
+/**
+ * Returns whether the rs485 line driver is enabled.
+ */
+bool turag_feldbus_sim_rts_enabled(void);
+
+/**
+ * Completes a simulated DMA reception while no transport is open.
+ *
+ * Copies data into the buffer passed to turag_feldbus_device_start_block_receive()
+ * and ends the reception. The caller is expected to call
+ * turag_feldbus_device_block_received() with the returned length afterwards.
+ * @param data		received bytes
+ * @param length	number of received bytes
+ * @return			length or 0 if no reception was started
+ *
+ * \pre Nur sinnvoll, wenn \ref TURAG_FELDBUS_DEVICE_CONFIG_BLOCK_TRANSFER auf 1 definiert ist.
+ */
+size_t turag_feldbus_sim_receive_block(const uint8_t* data, size_t length);
+
+/**
+ * Returns whether a transmission started with turag_feldbus_device_transmit_block()
+ * was not completed with turag_feldbus_device_block_transmitted() yet.
+ */
+bool turag_feldbus_sim_block_transmit_pending(void);
+
+/**
+ * Fetches bytes that were transmitted while no transport was open.
+ * @param buffer	destination
+ * @param size		capacity of buffer
+ * @return			number of bytes copied into buffer
+ */
+size_t turag_feldbus_sim_read_transmitted(uint8_t* buffer, size_t size);
+
+/**
+ * Backs the static storage of the device with a file.
+ *
+ * Implemented in feldbus_sim_storage.cpp, which provides
+ * turag_feldbus_device_get_static_storage_capacity(),
+ * turag_feldbus_device_get_static_storage_page_size(),
+ * turag_feldbus_device_read_from_static_storage() and
+ * turag_feldbus_device_write_to_static_storage(). Only compile it if
+ * the device firmware does not define these functions itself.
+ *
+ * A missing or shorter file is filled up with 0xff, like erased flash.
+ * Writes have to start at a multiple of page_size and are synced
+ * to the file immediately, so the file survives a killed process.
+ * @param path		file to use
+ * @param capacity	capacity of the storage in bytes
+ * @param page_size	page size of the storage, at least 1
+ * @return 0 on success, -1 on error (errno is set accordingly)
+ */
+int turag_feldbus_sim_storage_open(const char* path, uint32_t capacity, uint16_t page_size);
+
+/**
+ * Closes the file opened with turag_feldbus_sim_storage_open(). Afterwards the
+ * storage has a capacity of 0 again.
+ */
+void turag_feldbus_sim_storage_close(void);
+
+/**
+ * Returns the number of successful calls to turag_feldbus_device_write_to_static_storage()
+ * per page, e.g. to check the wear of a storage layout.
+ * @param page		page index
+ * @return			number of writes that touched this page since opening the file
+ */
+uint32_t turag_feldbus_sim_storage_page_writes(uint32_t page);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif // TURAG_FELDBUS_SIM_FELDBUS_SIM_H_
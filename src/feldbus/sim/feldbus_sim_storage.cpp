@@ -0,0 +1,102 @@
+#include "feldbus_sim.h"
+#include <feldbus/device/feldbus_base.h>
+
+#include <cerrno>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+struct Storage {
+	int fd = -1;
+	uint32_t capacity = 0;
+	uint16_t page_size = 1;
+	std::vector<uint32_t> page_writes;
+};
+
+Storage storage;
+
+} // namespace
+
+
+extern "C" int turag_feldbus_sim_storage_open(const char* path, uint32_t capacity, uint16_t page_size) {
+	if (page_size == 0 || capacity % page_size != 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	turag_feldbus_sim_storage_close();
+
+	int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		return -1;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		int error = errno;
+		close(fd);
+		errno = error;
+		return -1;
+	}
+
+	// fill up like erased flash
+	if ((uint64_t)st.st_size < capacity) {
+		std::vector<uint8_t> erased(capacity - st.st_size, 0xff);
+		if (pwrite(fd, erased.data(), erased.size(), st.st_size) != (ssize_t)erased.size() || fsync(fd) < 0) {
+			int error = errno ? errno : EIO;
+			close(fd);
+			errno = error;
+			return -1;
+		}
+	}
+
+	storage.fd = fd;
+	storage.capacity = capacity;
+	storage.page_size = page_size;
+	storage.page_writes.assign(capacity / page_size, 0);
+	return 0;
+}
+
+extern "C" void turag_feldbus_sim_storage_close(void) {
+	if (storage.fd >= 0) {
+		close(storage.fd);
+	}
+	storage = Storage();
+}
+
+extern "C" uint32_t turag_feldbus_sim_storage_page_writes(uint32_t page) {
+	return page < storage.page_writes.size() ? storage.page_writes[page] : 0;
+}
+
+
+extern "C" uint32_t turag_feldbus_device_get_static_storage_capacity() {
+	return storage.capacity;
+}
+
+extern "C" uint16_t turag_feldbus_device_get_static_storage_page_size() {
+	return storage.page_size;
+}
+
+extern "C" uint8_t turag_feldbus_device_read_from_static_storage(uint32_t offset, uint16_t size, uint8_t* buffer) {
+	if (storage.fd < 0 || (uint64_t)offset + size > storage.capacity) {
+		return 1;
+	}
+	return pread(storage.fd, buffer, size, offset) == size ? 0 : 2;
+}
+
+extern "C" uint8_t turag_feldbus_device_write_to_static_storage(uint32_t offset, const uint8_t* data, uint16_t size) {
+	if (storage.fd < 0 || (uint64_t)offset + size > storage.capacity || offset % storage.page_size != 0) {
+		return 1;
+	}
+	if (pwrite(storage.fd, data, size, offset) != size || fdatasync(storage.fd) < 0) {
+		return 2;
+	}
+	for (uint32_t page = offset / storage.page_size; page * storage.page_size < offset + size; ++page) {
+		++storage.page_writes[page];
+	}
+	return 0;
+}
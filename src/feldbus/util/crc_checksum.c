@@ -2,16 +2,16 @@
 #include <stdint.h>
 #include <stddef.h>
 
-static const uint8_t crc8_table[256];
-static const uint16_t crc16_table[256];
+#include "crc_checksum.h"
+
 
 
 
 uint8_t turag_crc8_calculate(const void* data, size_t length) {
-	uint8_t crc = 0xfd;
+	uint8_t crc = TURAG_CRC8_INIT;
 
     while (length--) {
-        crc = crc8_table[crc ^ *(uint8_t*)data];
+        crc = turag_crc8_table[crc ^ *(uint8_t*)data];
 		data = (uint8_t*)data + 1;
 	}
     return crc;
@@ -20,10 +20,10 @@ uint8_t turag_crc8_calculate(const void* data, size_t length) {
 
 uint16_t turag_crc16_calculate(const void* data, size_t length)
 {
-	uint16_t crc = 0xffff;
+	uint16_t crc = TURAG_CRC16_INIT;
 
     while (length--) {
-        crc = crc16_table[(crc >> 8) ^ *(uint8_t*)data] ^ (crc << 8);
+        crc = turag_crc16_table[(crc >> 8) ^ *(uint8_t*)data] ^ (crc << 8);
         data = (uint8_t*)data + 1;
     }
     return crc;
@@ -34,7 +34,7 @@ uint16_t turag_crc16_calculate(const void* data, size_t length)
 /**
  * Const data table used for the table_driven implementation.
  *****************************************************************************/
-static const uint8_t crc8_table[256] = {
+const uint8_t turag_crc8_table[256] = {
     0x00, 0x1d, 0x3a, 0x27, 0x74, 0x69, 0x4e, 0x53, 0xe8, 0xf5, 0xd2, 0xcf, 0x9c, 0x81, 0xa6, 0xbb,
     0xcd, 0xd0, 0xf7, 0xea, 0xb9, 0xa4, 0x83, 0x9e, 0x25, 0x38, 0x1f, 0x02, 0x51, 0x4c, 0x6b, 0x76,
     0x87, 0x9a, 0xbd, 0xa0, 0xf3, 0xee, 0xc9, 0xd4, 0x6f, 0x72, 0x55, 0x48, 0x1b, 0x06, 0x21, 0x3c,
@@ -58,7 +58,7 @@ static const uint8_t crc8_table[256] = {
 /**
  * Static table used for the table_driven implementation.
  */
-static const uint16_t crc16_table[256] = {
+const uint16_t turag_crc16_table[256] = {
     0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
     0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
     0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
@@ -39,6 +39,11 @@ extern "C" {
  *    Algorithm    = table-driven
  */
 
+/// Initial value of the CRC8-checksum (CRC-8/I-CODE)
+#define TURAG_CRC8_INIT		0xfd
+
+/// Lookup table used by turag_crc8_calculate() and turag_crc8_update()
+extern const uint8_t turag_crc8_table[256];
 
 /** Calculates a CRC8-checksum (using CRC-8/I-CODE)
  * @param		data	pointer to data that is to be included in the calculation
@@ -57,6 +62,18 @@ static inline bool turag_crc8_check(const void* data, size_t length, uint8_t chk
     return chksum == turag_crc8_calculate(data, length);
 }
 
+/** Adds one byte to a running CRC8-checksum (using CRC-8/I-CODE)
+ * @param		crc		current value of the checksum, start with \ref TURAG_CRC8_INIT
+ * @param		byte	data byte to add
+ * @return		updated checksum
+ *
+ * Adding the checksum of the data itself yields 0. This allows
+ * checking a frame while it is being received.
+ */
+static inline uint8_t turag_crc8_update(uint8_t crc, uint8_t byte) {
+    return turag_crc8_table[crc ^ byte];
+}
+
 
 
 /**
@@ -74,6 +91,12 @@ static inline bool turag_crc8_check(const void* data, size_t length, uint8_t chk
  *  - Algorithm     = table-driven
  */
 
+/// Initial value of the CRC16-checksum (CRC-16/IBM-3740)
+#define TURAG_CRC16_INIT	0xffff
+
+/// Lookup table used by turag_crc16_calculate() and turag_crc16_update()
+extern const uint16_t turag_crc16_table[256];
+
 /** Calculates a CRC16-checksum (using CCRC-16/IBM-3740)
  * @param		data	pointer to data that is to be included in the calculation
  * @param		length	length in bytes of the given data pointer
@@ -91,6 +114,17 @@ static inline bool turag_crc16_check(const void* data, size_t length, uint16_t c
     return chksum == turag_crc16_calculate(data, length);
 }
 
+/** Adds one byte to a running CRC16-checksum (using CRC-16/IBM-3740)
+ * @param		crc		current value of the checksum, start with \ref TURAG_CRC16_INIT
+ * @param		byte	data byte to add
+ * @return		updated checksum
+ *
+ * Adding the checksum of the data itself (most significant byte first) yields 0.
+ */
+static inline uint16_t turag_crc16_update(uint16_t crc, uint8_t byte) {
+    return turag_crc16_table[(crc >> 8) ^ byte] ^ (uint16_t)(crc << 8);
+}
+
 
 
 
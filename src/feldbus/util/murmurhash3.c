@@ -8,6 +8,8 @@
 
 #include <stdint.h>
 
+#include "murmurhash3.h"
+
 
 //-----------------------------------------------------------------------------
 // Platform-specific functions and macros
@@ -119,3 +121,60 @@ uint32_t murmurhash3_x86_32 (const void * key, int len, uint32_t seed)
 
 //-----------------------------------------------------------------------------
 
+// Incremental version of murmurhash3_x86_32(). Bytes are collected to
+// blocks in little endian order, so the result equals the one of
+// murmurhash3_x86_32() on little endian platforms regardless of
+// how the data is split.
+
+static inline uint32_t mix_k1 ( uint32_t k1 )
+{
+  k1 *= 0xcc9e2d51;
+  k1 = ROTL32(k1,15);
+  k1 *= 0x1b873593;
+
+  return k1;
+}
+
+void murmurhash3_x86_32_init (murmurhash3_x86_32_state * state, uint32_t seed)
+{
+  state->h1 = seed;
+  state->tail = 0;
+  state->len = 0;
+}
+
+void murmurhash3_x86_32_update (murmurhash3_x86_32_state * state, const void * key, int len)
+{
+  const uint8_t * data = (const uint8_t*)key;
+
+  for(int i = 0; i < len; i++)
+  {
+    state->tail |= (uint32_t)data[i] << (8 * (state->len & 3));
+    state->len++;
+
+    if((state->len & 3) == 0)
+    {
+      state->h1 ^= mix_k1(state->tail);
+      state->h1 = ROTL32(state->h1,13);
+      state->h1 = state->h1*5+0xe6546b64;
+      state->tail = 0;
+    }
+  }
+}
+
+uint32_t murmurhash3_x86_32_final (const murmurhash3_x86_32_state * state)
+{
+  uint32_t h1 = state->h1;
+
+  if(state->len & 3)
+  {
+    h1 ^= mix_k1(state->tail);
+  }
+
+  h1 ^= state->len;
+
+  return fmix32(h1);
+}
+
+
+
+//-----------------------------------------------------------------------------
@@ -23,6 +23,19 @@ extern "C" {
 uint32_t murmurhash3_x86_32  (const void * key, int len, uint32_t seed);
 
 
+// incremental calculation of murmurhash3_x86_32() for data
+// that is not available in one piece
+typedef struct {
+  uint32_t h1;
+  uint32_t tail;
+  uint32_t len;
+} murmurhash3_x86_32_state;
+
+void     murmurhash3_x86_32_init   (murmurhash3_x86_32_state * state, uint32_t seed);
+void     murmurhash3_x86_32_update (murmurhash3_x86_32_state * state, const void * key, int len);
+uint32_t murmurhash3_x86_32_final  (const murmurhash3_x86_32_state * state);
+
+
 #ifdef __cplusplus
 }           /* closing brace for extern "C" */
 #endif
@@ -62,6 +62,18 @@ static inline bool xor_checksum_check(const void* data, unsigned size, uint8_t c
 	}
 }
 
+/** 
+ * @brief Adds one byte to a running 8Bit-XOR-checksum.
+ * @param[in]	chksum	current value of the checksum, start with 0
+ * @param[in]	byte	data byte to add
+ * @return		updated checksum
+ *
+ * Adding the checksum of the data itself yields 0.
+ */
+static inline uint8_t xor_checksum_update(uint8_t chksum, uint8_t byte) {
+	return chksum ^ byte;
+}
+
 /**
  * @}
  */